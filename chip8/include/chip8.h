@@ -6,35 +6,206 @@
 
 #define FONTSET_START_ADDRESS 50
 #define FONT_SIZE 5
+/* The SUPER-CHIP font of 8x10 digits, right after the small font. */
+#define BIG_FONTSET_START_ADDRESS (FONTSET_START_ADDRESS + 16 * FONT_SIZE)
+#define BIG_FONT_SIZE 10
 
 #define CHIP8_SCREEN_WIDTH 64
 #define CHIP8_SCREEN_HEIGHT 32
+/* The SUPER-CHIP high resolution mode. */
+#define CHIP8_HIRES_WIDTH 128
+#define CHIP8_HIRES_HEIGHT 64
+/* The number of 64-bit words in a row of the high resolution screen. */
+#define CHIP8_SCREEN_WORDS (CHIP8_HIRES_WIDTH / 64)
+/* The bitplanes of XO-CHIP, selected by Fn01. A pixel has one bit in every
+ * plane, which together make its colour. */
+#define CHIP8_PLANES 4
+#define CHIP8_COLOURS (1 << CHIP8_PLANES)
+/* The bits of Chip8.dirty_rows that stand for every row of the screen. */
+#define CHIP8_ALL_ROWS UINT64_MAX
 
 #define ENTRY_POINT 0x200
 
+/* The 64 KiB of XO-CHIP. The other platforms only address the first 4 KiB. */
+#define CHIP8_MEMORY_SIZE 0x10000
+/* One predecoded instruction for every even address of the memory. */
+#define CHIP8_DECODED_SIZE (CHIP8_MEMORY_SIZE / 2)
+/* The 1-bit samples of the XO-CHIP audio pattern, loaded by F002. */
+#define CHIP8_AUDIO_PATTERN_SIZE 16
+/* The pitch of the audio pattern that plays it at 4000 samples per second. */
+#define CHIP8_DEFAULT_PITCH 64
+
 /* Macro to extract a specific nibble (0-7) from a hex value */
 #define GET_NIBBLE(hexValue, index) (((hexValue) >> ((index) * 4)) & 0xF)
 
 #define X_NIBBLE 2
 #define Y_NIBBLE 1
 
-#define SPECIFIED_TIME 0.0166
+/* The instructions that an opcode can be decoded to. */
+typedef enum {
+  CHIP8_OP_IGNORE = 0,
+  CHIP8_OP_TRAP,
+  CHIP8_OP_00CN,
+  CHIP8_OP_00E0,
+  CHIP8_OP_00EE,
+  CHIP8_OP_00FB,
+  CHIP8_OP_00FC,
+  CHIP8_OP_00FD,
+  CHIP8_OP_00FE,
+  CHIP8_OP_00FF,
+  CHIP8_OP_1NNN,
+  CHIP8_OP_2NNN,
+  CHIP8_OP_3XKK,
+  CHIP8_OP_4XKK,
+  CHIP8_OP_5XY0,
+  CHIP8_OP_5XY2,
+  CHIP8_OP_5XY3,
+  CHIP8_OP_6XKK,
+  CHIP8_OP_7XKK,
+  CHIP8_OP_8XY0,
+  CHIP8_OP_8XY1,
+  CHIP8_OP_8XY2,
+  CHIP8_OP_8XY3,
+  CHIP8_OP_8XY4,
+  CHIP8_OP_8XY5,
+  CHIP8_OP_8XY6,
+  CHIP8_OP_8XY7,
+  CHIP8_OP_8XYE,
+  CHIP8_OP_9XY0,
+  CHIP8_OP_ANNN,
+  CHIP8_OP_BNNN,
+  CHIP8_OP_CXKK,
+  CHIP8_OP_DXYN,
+  CHIP8_OP_EX9E,
+  CHIP8_OP_EXA1,
+  CHIP8_OP_F000,
+  CHIP8_OP_FN01,
+  CHIP8_OP_F002,
+  CHIP8_OP_FX07,
+  CHIP8_OP_FX0A,
+  CHIP8_OP_FX15,
+  CHIP8_OP_FX18,
+  CHIP8_OP_FX1E,
+  CHIP8_OP_FX29,
+  CHIP8_OP_FX30,
+  CHIP8_OP_FX33,
+  CHIP8_OP_FX3A,
+  CHIP8_OP_FX55,
+  CHIP8_OP_FX65,
+  CHIP8_OP_FX75,
+  CHIP8_OP_FX85,
+  CHIP8_OP_COUNT
+} Chip8Op;
+
+/* The platforms whose quirks can be emulated. */
+typedef enum {
+  CHIP8_PROFILE_CHIP8 = 0, /* The original COSMAC VIP interpreter. */
+  CHIP8_PROFILE_SCHIP,     /* SUPER-CHIP 1.1 on the HP 48. */
+  CHIP8_PROFILE_XOCHIP,    /* XO-CHIP. */
+  CHIP8_PROFILE_COUNT
+} Chip8Profile;
+
+/* The behaviours that differ between the profiles. */
+typedef struct chip8_quirks {
+  uint8_t shift_vy;       /* 8xy6 and 8xyE shift Vy instead of Vx. */
+  uint8_t load_store_inc; /* Fx55 and Fx65 increment I. */
+  uint8_t jump_vx;        /* Bxnn jumps to xnn + Vx instead of nnn + V0. */
+  uint8_t vf_reset;       /* 8xy1, 8xy2 and 8xy3 reset VF. */
+  uint8_t clip;           /* Dxyn clips the sprites instead of wrapping them. */
+  uint8_t sprite16;       /* Dxy0 draws a 16x16 sprite. */
+  uint8_t superchip;      /* The SUPER-CHIP instructions are available. */
+  uint8_t xochip;         /* The XO-CHIP instructions are available. */
+} Chip8Quirks;
+
+/* The reasons chip8_run_cycles() can stop for. */
+typedef enum {
+  CHIP8_STOP_BUDGET = 0, /* All the requested cycles were executed. */
+  CHIP8_STOP_WAIT_KEY,   /* Fx0A is waiting for a key to be pressed. */
+  CHIP8_STOP_DRAW,       /* 00E0 or Dxyn changed the display. */
+  CHIP8_STOP_BREAKPOINT, /* The PC reached a breakpoint. */
+  CHIP8_STOP_TRAP,       /* An invalid opcode halted the execution. */
+  CHIP8_STOP_IDLE,       /* An idle loop waits for the next timer tick. */
+  CHIP8_STOP_EXIT        /* 00FD exited the interpreter. */
+} Chip8Stop;
+
+struct chip8;
+struct chip8_inst;
+
+typedef void (*function) (struct chip8 *self, const struct chip8_inst *inst);
+
+/* An instruction with its handler resolved and its operands extracted. */
+typedef struct chip8_inst {
+  function handler; /* NULL if the instruction has to be decoded again. */
+  uint16_t op_code;
+  uint16_t nnn;
+  uint8_t x;
+  uint8_t y;
+  uint8_t n;
+  uint8_t kk;
+  uint8_t kind; /* The Chip8Op the opcode was decoded to. */
+} Chip8Inst;
 
 typedef struct chip8 {
   uint8_t registers[16];
-  uint8_t memory[4096];
+  uint8_t memory[CHIP8_MEMORY_SIZE];
   uint16_t pc;
   uint16_t ir;
-  uint8_t graphics[CHIP8_SCREEN_WIDTH][CHIP8_SCREEN_HEIGHT];
+  /* One word per row for every 64 columns of every plane, the most significant
+   * bit is the leftmost pixel of the word. The low resolution screen only uses
+   * the top left 64x32 pixels. */
+  uint64_t graphics[CHIP8_PLANES][CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT];
+  uint8_t hires;  /* Set in the 128x64 mode of the SUPER-CHIP. */
+  uint8_t planes; /* The planes drawn on by Fn01, plane p in bit p. */
+  uint64_t dirty_rows; /* The rows changed since they were last presented. */
+  uint64_t row_hashes[CHIP8_HIRES_HEIGHT]; /* The hash of every row. */
+  uint64_t screen_hash;    /* The sum of the row hashes. */
+  uint64_t presented_hash; /* The frame hash when it was last presented. */
   uint16_t stack[16];
   uint8_t sp;
+  /* The timers are only worked out when read, from the value they were set to
+   * and the tick they were set at. */
   uint8_t delay_timer;
   uint8_t sound_timer;
+  uint64_t delay_tick;
+  uint64_t sound_tick;
+  uint32_t timer_rate;  /* The instructions per second the timers tick at. */
+  uint64_t timer_cycle; /* The cycle timer_rate was set at. */
+  uint64_t timer_ticks; /* The ticks before timer_cycle. */
+  uint64_t timer_phase; /* The part of a tick run before timer_cycle, times
+                         * CHIP8_CLOCK_FRAME_RATE, below timer_rate. */
   uint16_t op_code;
   uint8_t keypad[16];
+  uint8_t flags[16]; /* The flag registers saved by Fx75. */
+  uint8_t audio_pattern[CHIP8_AUDIO_PATTERN_SIZE]; /* Loaded by F002. */
+  uint8_t pitch; /* The pitch of the audio pattern, set by Fx3A. */
   uint8_t *rom_name;
+  uint8_t trapped; /* Set once an invalid opcode halted the execution. */
+  uint8_t profile; /* The Chip8Profile of the loaded ROM. */
+  const function *handlers;  /* The handlers specialized for the profile. */
+  const Chip8Quirks *quirks; /* The quirks of the profile. */
+  uint8_t stop;    /* The Chip8Stop raised by the last instruction. */
+  uint64_t cycles; /* The number of cycles run, that the timers count. */
+  uint64_t idle_cycles; /* The cycles skipped in idle loops. */
+  uint32_t idle_skips;  /* The number of times idle loops were skipped. */
+  uint16_t breakpoint_count;
+  uint8_t breakpoints[CHIP8_MEMORY_SIZE];
+  const Chip8Inst *inst; /* The instruction fetched by chip8_parse_code(). */
+  Chip8Inst scratch;     /* Decoded instruction fetched from an odd address. */
+  Chip8Inst decoded[CHIP8_DECODED_SIZE];
+  struct chip8_jit *jit; /* The state of the JIT, allocated on its first use. */
+  struct chip8_aot *aot; /* The recompiled ROM, if one was loaded. */
+  struct chip8_trace *trace; /* The trace ring buffer, if it was started. */
 } Chip8;
 
+/* The screen alone, as the window draws it from the frames of the emulation,
+ * laid out like the screen of a Chip8 object. */
+typedef struct chip8_screen {
+  uint64_t graphics[CHIP8_PLANES][CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT];
+  uint64_t row_hashes[CHIP8_HIRES_HEIGHT]; /* The hash of every row. */
+  uint64_t dirty_rows; /* The rows changed since they were last drawn. */
+  uint8_t hires;       /* Set in the 128x64 mode of the SUPER-CHIP. */
+} Chip8Screen;
+
 typedef enum {
   V0 = 0,
   V1,
@@ -54,14 +225,74 @@ typedef enum {
   VF
 } GeneralPurposeRegs;
 
-typedef void (*function) (Chip8 *self) ;
+/**
+ * @brief Reads a pixel of the screen.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param x The column of the pixel, from the left.
+ * @param y The row of the pixel, from the top.
+ * @return The colour of the pixel, with bit p set if it's lit in plane p. 0 is
+ * an unlit pixel, and 1 a lit one when only the first plane is drawn on.
+ */
+static inline uint8_t chip8_pixel(const Chip8 *self, uint8_t x, uint8_t y) {
+  uint8_t colour = 0;
+
+  for (uint8_t p = 0; p < CHIP8_PLANES; p++) {
+    colour |= ((self->graphics[p][x / 64][y] >> (63 - x % 64)) & 1) << p;
+  }
+
+  return colour;
+}
+
+/**
+ * @brief Returns the width of the screen in the current mode.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+static inline uint8_t chip8_screen_width(const Chip8 *self) {
+  return self->hires ? CHIP8_HIRES_WIDTH : CHIP8_SCREEN_WIDTH;
+}
+
+/**
+ * @brief Returns the height of the screen in the current mode.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+static inline uint8_t chip8_screen_height(const Chip8 *self) {
+  return self->hires ? CHIP8_HIRES_HEIGHT : CHIP8_SCREEN_HEIGHT;
+}
+
+struct chip8_render;
 
 int chip8_init(Chip8 *self);
+void chip8_deinit(Chip8 *self);
 int chip8_load_rom(Chip8 *self, char *usr_rom_name);
+void chip8_decode(uint16_t op_code, Chip8Inst *inst);
+void chip8_decode_memory(Chip8 *self);
+void chip8_set_profile(Chip8 *self, Chip8Profile profile);
+Chip8Profile chip8_profile_from_name(const char *rom_name);
 void chip8_parse_code(Chip8 *self);
 void chip8_inst_emulate(Chip8 *self);
+void chip8_execute_opcode(Chip8 *self, uint16_t op_code);
+uint32_t chip8_execute(Chip8 *self, uint32_t count);
+uint32_t chip8_execute_table(Chip8 *self, uint32_t count);
+uint32_t chip8_execute_threaded(Chip8 *self, uint32_t count);
+uint32_t chip8_execute_direct(Chip8 *self, uint32_t count);
+uint32_t chip8_execute_jit(Chip8 *self, uint32_t count);
+uint32_t chip8_execute_aot(Chip8 *self, uint32_t count);
+Chip8Stop chip8_run_cycles(Chip8 *self, uint32_t n);
+int chip8_idle_jump(const uint8_t *memory, uint16_t addr, uint16_t target);
+void chip8_set_breakpoint(Chip8 *self, uint16_t addr, uint8_t enabled);
+uint16_t chip8_keyboard_read(void);
+void chip8_set_keys(Chip8 *self, uint16_t keys);
 void chip8_keyboard_control(Chip8 *self);
-void chip8_draw(Chip8 *self, Rectangle *pixel);
-void chip8_timer_control(Chip8 *self);
+uint64_t chip8_frame_hash(Chip8 *self);
+uint64_t chip8_take_dirty_rows(Chip8 *self);
+void chip8_draw(Chip8Screen *screen, struct chip8_render *render,
+                Texture2D *texture);
+void chip8_set_rate(Chip8 *self, uint32_t rate);
+uint64_t chip8_timer_ticks(const Chip8 *self);
+uint8_t chip8_delay_timer(const Chip8 *self);
+uint8_t chip8_sound_timer(const Chip8 *self);
 
 #endif // CHIP8_H_
@@ -0,0 +1,38 @@
+#ifndef CHIP8_AOT_H_
+#define CHIP8_AOT_H_
+
+#include "chip8.h"
+#include <stdint.h>
+
+/* The maximum number of instructions in a recompiled block. */
+#define CHIP8_AOT_MAX_LENGTH 64
+/* The version of the interface between the recompiled blocks and the
+ * emulator, the shared objects of other versions are rejected. */
+#define CHIP8_AOT_VERSION 2
+
+/* A basic block recompiled to a native function by tools/chip8_aot. The
+ * function returns the number of instructions it executed, counts them in the
+ * cycles of the Chip8 object, and leaves the PC at the next instruction to be
+ * executed. */
+typedef struct chip8_aot_block {
+  uint16_t start;  /* The address of the first instruction. */
+  uint16_t end;    /* The address past the last instruction, or past the
+                    * instruction skipped at the end on XO-CHIP. */
+  uint16_t length; /* The number of instructions. */
+  uint32_t (*run)(Chip8 *self);
+} Chip8AotBlock;
+
+typedef struct chip8_aot {
+  void *handle; /* The handle of the loaded shared object. */
+  const Chip8AotBlock *blocks[CHIP8_DECODED_SIZE]; /* By start address / 2. */
+  uint8_t cover[CHIP8_DECODED_SIZE]; /* Blocks over each address. */
+} Chip8Aot;
+
+/* Computes the hash that ties a recompiled shared object to its ROM. */
+uint32_t chip8_aot_hash(const uint8_t *rom, uint32_t size);
+
+int chip8_aot_load(Chip8 *self, const char *path);
+void chip8_aot_invalidate(Chip8 *self, uint16_t addr);
+void chip8_aot_free(Chip8 *self);
+
+#endif // CHIP8_AOT_H_
@@ -0,0 +1,16 @@
+#ifndef CHIP8_BLIT_H_
+#define CHIP8_BLIT_H_
+
+#include "chip8.h"
+#include <stdint.h>
+
+/* The number of bytes read for the largest sprite, a 16x16 one. */
+#define CHIP8_BLIT_MAX_SPRITE 32
+
+uint8_t chip8_blit(uint64_t screen[][CHIP8_HIRES_HEIGHT], uint8_t width,
+                   uint8_t height, const uint8_t *sprite, uint8_t x, uint8_t y,
+                   uint8_t rows, uint8_t wide, uint8_t clip);
+uint64_t chip8_blit_rows(uint8_t height, uint8_t y, uint8_t rows,
+                         uint8_t clip);
+
+#endif // CHIP8_BLIT_H_
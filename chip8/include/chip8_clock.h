@@ -0,0 +1,30 @@
+#ifndef CHIP8_CLOCK_H_
+#define CHIP8_CLOCK_H_
+
+#include <stdint.h>
+
+/* The rate of the frames and of the timers, independent of the CPU. */
+#define CHIP8_CLOCK_FRAME_RATE 60
+/* The range of CPU rates, in instructions per second. */
+#define CHIP8_CLOCK_MIN_RATE 500
+#define CHIP8_CLOCK_MAX_RATE 100000000
+/* The rate most CHIP-8 ROMs are written for. */
+#define CHIP8_CLOCK_DEFAULT_RATE 700
+
+/* Turns a CPU rate into a number of instructions for every frame. */
+typedef struct chip8_clock {
+  uint32_t rate;  /* The instructions per second. */
+  uint32_t carry; /* The part of rate / frame rate left over from the last
+                   * frames, in 1/CHIP8_CLOCK_FRAME_RATE of an instruction. */
+  uint64_t executed;    /* The instructions executed since the last sample. */
+  double sample_start;  /* The time of the last sample, in seconds. */
+  double ips;           /* The instructions per second of the last sample. */
+} Chip8Clock;
+
+uint32_t chip8_clock_clamp(uint32_t rate);
+void chip8_clock_init(Chip8Clock *self, uint32_t rate);
+void chip8_clock_set_rate(Chip8Clock *self, uint32_t rate);
+uint32_t chip8_clock_budget(Chip8Clock *self);
+int chip8_clock_sample(Chip8Clock *self, uint32_t executed, double now);
+
+#endif // CHIP8_CLOCK_H_
@@ -0,0 +1,37 @@
+#ifndef CHIP8_FRAMES_H_
+#define CHIP8_FRAMES_H_
+
+#include "chip8.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* Set in the middle index of a Chip8Frames when its frame wasn't taken yet. */
+#define CHIP8_FRAMES_FRESH 0x4
+
+/* A finished frame, passed from the emulation to the renderer. */
+typedef struct chip8_frame {
+  uint64_t graphics[CHIP8_PLANES][CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT];
+  uint64_t row_hashes[CHIP8_HIRES_HEIGHT]; /* The hash of every row. */
+  uint64_t time;  /* The number of the frame, from 0. */
+  uint8_t hires;
+} Chip8Frame;
+
+/* A triple buffer between one thread that writes frames and one that draws
+ * them, without locks. The writer fills the back frame and the reader draws
+ * the front one, and each swaps its own with the middle one when it's done,
+ * so neither ever waits for the other. The reader always gets the latest
+ * frame, and the frames written in between are dropped. */
+typedef struct chip8_frames {
+  Chip8Frame frames[3];
+  uint8_t back;  /* The frame of the writer. */
+  uint8_t front; /* The frame of the reader. */
+  /* The index of the frame in between, with CHIP8_FRAMES_FRESH. */
+  _Atomic uint8_t middle;
+} Chip8Frames;
+
+void chip8_frames_init(Chip8Frames *self);
+void chip8_frames_publish(Chip8Frames *self, Chip8 *chip8, uint64_t time);
+const Chip8Frame *chip8_frames_take(Chip8Frames *self);
+void chip8_frames_show(const Chip8Frame *frame, Chip8Screen *display);
+
+#endif // CHIP8_FRAMES_H_
@@ -0,0 +1,36 @@
+#ifndef CHIP8_JIT_H_
+#define CHIP8_JIT_H_
+
+#include "chip8.h"
+#include <stdint.h>
+
+/* The size of the executable memory that holds the translated blocks. */
+#define CHIP8_JIT_CODE_SIZE (256 * 1024)
+/* The number of times a block is entered before it gets translated. */
+#define CHIP8_JIT_HOT_THRESHOLD 16
+/* The maximum number of instructions in a translated block. */
+#define CHIP8_JIT_MAX_LENGTH 32
+
+/* A translated block returns the number of instructions it executed. */
+typedef uint32_t (*chip8_jit_code) (Chip8 *self);
+
+typedef struct chip8_jit_block {
+  chip8_jit_code code;   /* NULL if the block isn't translated. */
+  uint16_t end;          /* The address past the last instruction, or past
+                          * the instruction skipped at the end on XO-CHIP. */
+  uint16_t length;       /* The number of instructions. */
+  uint8_t hits;          /* The number of times the block was entered. */
+  uint8_t untranslatable;/* Set if the first instruction can't be translated. */
+} Chip8JitBlock;
+
+typedef struct chip8_jit {
+  uint8_t *code; /* The executable memory. */
+  uint32_t used; /* The number of bytes of code emitted so far. */
+  Chip8JitBlock blocks[CHIP8_DECODED_SIZE]; /* Indexed by start address / 2. */
+  uint8_t cover[CHIP8_DECODED_SIZE]; /* Translated blocks over each address. */
+} Chip8Jit;
+
+void chip8_jit_invalidate(Chip8 *self, uint16_t addr);
+void chip8_jit_free(Chip8 *self);
+
+#endif // CHIP8_JIT_H_
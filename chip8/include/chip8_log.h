@@ -0,0 +1,37 @@
+#ifndef CHIP8_LOG_H_
+#define CHIP8_LOG_H_
+
+#include <stdio.h>
+
+/* The log levels, from the least to the most verbose. */
+#define CHIP8_LOG_LEVEL_NONE 0
+#define CHIP8_LOG_LEVEL_ERROR 1 /* Failures, on stderr. */
+#define CHIP8_LOG_LEVEL_INFO 2  /* One-off events, such as loading a ROM. */
+#define CHIP8_LOG_LEVEL_DEBUG 3 /* Dumps of the state, such as the memory. */
+#define CHIP8_LOG_LEVEL_TRACE 4 /* Every instruction and every frame. */
+
+/* The most verbose level that is compiled in, e.g. with
+ * -DCHIP8_LOG_LEVEL=CHIP8_LOG_LEVEL_TRACE. */
+#ifndef CHIP8_LOG_LEVEL
+#define CHIP8_LOG_LEVEL CHIP8_LOG_LEVEL_ERROR
+#endif
+
+/* Logs a message if its level is compiled in. The level is a constant, so the
+ * messages above CHIP8_LOG_LEVEL compile to nothing, while their arguments are
+ * still checked by the compiler. */
+#define CHIP8_LOG(level, stream, ...)                                          \
+  do {                                                                         \
+    if (CHIP8_LOG_LEVEL >= (level)) {                                          \
+      fprintf((stream), __VA_ARGS__);                                          \
+    }                                                                          \
+  } while (0)
+
+#define CHIP8_LOG_ERROR(...) CHIP8_LOG(CHIP8_LOG_LEVEL_ERROR, stderr, __VA_ARGS__)
+#define CHIP8_LOG_INFO(...) CHIP8_LOG(CHIP8_LOG_LEVEL_INFO, stdout, __VA_ARGS__)
+#define CHIP8_LOG_DEBUG(...) CHIP8_LOG(CHIP8_LOG_LEVEL_DEBUG, stdout, __VA_ARGS__)
+#define CHIP8_LOG_TRACE(...) CHIP8_LOG(CHIP8_LOG_LEVEL_TRACE, stdout, __VA_ARGS__)
+
+/* Checks if a level is compiled in, to skip the loops that only log. */
+#define CHIP8_LOG_ENABLED(level) (CHIP8_LOG_LEVEL >= (level))
+
+#endif // CHIP8_LOG_H_
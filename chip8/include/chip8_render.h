@@ -0,0 +1,35 @@
+#ifndef CHIP8_RENDER_H_
+#define CHIP8_RENDER_H_
+
+#include "chip8.h"
+#include <stdint.h>
+
+/* A colour, in the byte order of an RGBA texture. */
+typedef struct chip8_rgba {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+} Chip8Rgba;
+
+/* The screen converted to RGBA pixels on the CPU, ready to be uploaded to a
+ * texture. Nothing here needs a window or a GPU. */
+typedef struct chip8_render {
+  /* Indexed by the colour of a pixel, with bit p set if it's lit in plane
+   * p. */
+  Chip8Rgba palette[CHIP8_COLOURS];
+  uint8_t scale;        /* The size of a low resolution pixel, in pixels. */
+  uint8_t rounded;      /* Set to cut the corners of the lit pixels. */
+  uint16_t width;       /* The width of the buffer, in pixels. */
+  uint16_t height;      /* The height of the buffer, in pixels. */
+  Chip8Rgba *pixels;    /* The buffer, row by row from the top. */
+} Chip8Render;
+
+int chip8_render_init(Chip8Render *self, uint8_t scale, uint8_t rounded,
+                      Chip8Rgba off, Chip8Rgba on);
+uint8_t chip8_render_cell(const Chip8Render *self, const Chip8Screen *screen);
+void chip8_render_rows(Chip8Render *self, const Chip8Screen *screen,
+                       uint64_t rows);
+void chip8_render_deinit(Chip8Render *self);
+
+#endif // CHIP8_RENDER_H_
@@ -0,0 +1,87 @@
+#ifndef CHIP8_STREAM_H_
+#define CHIP8_STREAM_H_
+
+#include "chip8.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The number of frames waiting to be written, before new ones are dropped or
+ * wait. A power of two. */
+#define CHIP8_STREAM_QUEUE_SIZE 8
+/* The first bytes of a recording in the RLE format. */
+#define CHIP8_STREAM_RLE_MAGIC "C8RL"
+
+/* The formats frames can be streamed in. */
+typedef enum {
+  CHIP8_STREAM_RAW = 0, /* Packed rows, 1 bit per pixel, without headers. */
+  CHIP8_STREAM_PBM,     /* The same rows, each frame with a PBM header. */
+  CHIP8_STREAM_Y4M,     /* 8-bit grey pixels in a YUV4MPEG2 stream. */
+  CHIP8_STREAM_RLE      /* The changed frames, run-length encoded. */
+} Chip8StreamFormat;
+
+/* The header of an RLE recording, in the byte order of the host. */
+typedef struct chip8_stream_rle_header {
+  char magic[4];   /* CHIP8_STREAM_RLE_MAGIC. */
+  uint16_t width;  /* The width of the frames. */
+  uint16_t height; /* The height of the frames. */
+  uint16_t rate;   /* The number of frames per second. */
+  uint16_t reserved;
+} Chip8StreamRleHeader;
+
+/* The header of a frame of an RLE recording. The frames the same as the one
+ * before them aren't recorded, and a header without planes ends the file. */
+typedef struct chip8_stream_rle_frame {
+  uint64_t time;   /* The number of the frame, from 0. */
+  uint32_t size;   /* The number of bytes of PackBits data that follow. */
+  uint8_t planes;  /* The planes recorded, plane p in bit p. */
+  uint8_t reserved[3];
+} Chip8StreamRleFrame;
+
+/* A frame waiting to be written. */
+typedef struct chip8_stream_frame {
+  uint64_t graphics[CHIP8_PLANES][CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT];
+  uint64_t time;  /* The number of the frame, from 0. */
+  uint8_t hires;
+  uint8_t repeat; /* Set if the screen is the same as in the last frame. */
+} Chip8StreamFrame;
+
+/* The presented frames, written to a file or a pipe by a thread of their own,
+ * so that a slow reader never holds up the emulation. */
+typedef struct chip8_stream {
+  int fd;
+  uint8_t format;  /* The Chip8StreamFormat. */
+  uint8_t width;   /* The width of the frames, 64 or 128. */
+  uint8_t height;  /* The height of the frames, 32 or 64. */
+  uint8_t started; /* Set once a frame was queued. */
+  uint8_t wait;    /* Set to wait for the writer when the queue is full. */
+  uint64_t hash;   /* The frame hash of the last frame queued. */
+  uint64_t count;  /* The number of frames pushed, queued or not. */
+  uint64_t dropped; /* The frames dropped because the queue was full. */
+  /* The queue from the emulation to the writer. Only the emulation moves the
+   * head and only the writer moves the tail. */
+  _Atomic uint32_t head;
+  _Atomic uint32_t tail;
+  _Atomic uint8_t failed; /* Set once a write failed. */
+  sem_t queued; /* Posted for every frame queued, and once to close. */
+  sem_t written; /* Posted for every frame taken off the queue. */
+  uint8_t *buffer;  /* The last frame written, in the format of the stream. */
+  size_t size;      /* The size of the last frame written. */
+  uint8_t *scratch; /* The packed rows of a plane, before they're encoded. */
+  Chip8StreamFrame frames[CHIP8_STREAM_QUEUE_SIZE];
+  pthread_t writer;
+} Chip8Stream;
+
+extern const uint8_t chip8_stream_luma[CHIP8_COLOURS];
+
+int chip8_stream_open(Chip8Stream *self, int fd, Chip8StreamFormat format,
+                      uint8_t hires, uint8_t wait);
+int chip8_stream_push(Chip8Stream *self, Chip8 *chip8);
+void chip8_stream_close(Chip8Stream *self);
+size_t chip8_stream_packbits(const uint8_t *in, size_t size, uint8_t *out);
+size_t chip8_stream_unpackbits(const uint8_t *in, size_t size, uint8_t *out,
+                               size_t capacity);
+
+#endif // CHIP8_STREAM_H_
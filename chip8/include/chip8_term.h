@@ -0,0 +1,34 @@
+#ifndef CHIP8_TERM_H_
+#define CHIP8_TERM_H_
+
+#include "chip8.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* The characters the pixels are drawn with. */
+typedef enum {
+  CHIP8_TERM_HALF = 0, /* Half blocks, 1x2 pixels per character. */
+  CHIP8_TERM_BRAILLE   /* Braille patterns, 2x4 pixels per character. */
+} Chip8TermMode;
+
+/* The screen drawn in a terminal with escape sequences. Only the characters
+ * that changed since the last frame are written. */
+typedef struct chip8_term {
+  FILE *out;
+  uint8_t mode;    /* The Chip8TermMode. */
+  uint8_t drawn;   /* Set once the whole screen was drawn. */
+  uint8_t hires;   /* The mode of the screen that was drawn. */
+  uint8_t columns; /* The number of characters in a row of the screen. */
+  uint8_t rows;    /* The number of rows of characters. */
+  /* The pixels of every character drawn, bit i for its pixel i. */
+  uint8_t cells[CHIP8_HIRES_HEIGHT / 2][CHIP8_HIRES_WIDTH];
+  char *buffer;    /* The escape sequences of a frame. */
+  uint64_t bytes;  /* The number of bytes written so far. */
+} Chip8Term;
+
+int chip8_term_init(Chip8Term *self, FILE *out, Chip8TermMode mode);
+void chip8_term_draw(Chip8Term *self, const Chip8 *chip8, uint64_t dirty);
+void chip8_term_deinit(Chip8Term *self);
+
+#endif // CHIP8_TERM_H_
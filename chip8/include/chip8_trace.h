@@ -0,0 +1,63 @@
+#ifndef CHIP8_TRACE_H_
+#define CHIP8_TRACE_H_
+
+#include "chip8.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* The number of entries kept in the ring buffer, a power of two. */
+#define CHIP8_TRACE_SIZE 4096
+/* The first bytes of a trace file. */
+#define CHIP8_TRACE_MAGIC "C8TR"
+
+/* One executed instruction, with the operands it read. */
+typedef struct chip8_trace_entry {
+  uint16_t pc;      /* The address of the instruction. */
+  uint16_t op_code; /* The opcode of the instruction. */
+  uint16_t ir;      /* I before the instruction. */
+  uint8_t vx;       /* Vx before the instruction. */
+  uint8_t vy;       /* Vy before the instruction. */
+} Chip8TraceEntry;
+
+/* The last CHIP8_TRACE_SIZE executed instructions. */
+typedef struct chip8_trace {
+  uint64_t count; /* The number of instructions recorded so far. */
+  Chip8TraceEntry entries[CHIP8_TRACE_SIZE];
+} Chip8Trace;
+
+/**
+ * @brief Records an instruction that is about to be executed.
+ *
+ * Compiles to nothing unless CHIP8_TRACE_RING is defined, and does nothing
+ * until chip8_trace_start() is called.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param pc The address of the instruction.
+ * @param inst The decoded instruction.
+ */
+static inline void chip8_trace_record(Chip8 *self, uint16_t pc,
+                                      const Chip8Inst *inst) {
+#if defined(CHIP8_TRACE_RING)
+  Chip8Trace *trace = self->trace;
+
+  if (trace != NULL) {
+    Chip8TraceEntry *entry =
+        &trace->entries[trace->count++ & (CHIP8_TRACE_SIZE - 1)];
+    entry->pc = pc;
+    entry->op_code = inst->op_code;
+    entry->ir = self->ir;
+    entry->vx = self->registers[inst->x];
+    entry->vy = self->registers[inst->y];
+  }
+#else
+  (void)self;
+  (void)pc;
+  (void)inst;
+#endif
+}
+
+int chip8_trace_start(Chip8 *self);
+int chip8_trace_dump(const Chip8 *self, const char *path);
+void chip8_trace_free(Chip8 *self);
+
+#endif // CHIP8_TRACE_H_
@@ -1,9 +1,21 @@
 #include "chip8.h"
+#include "chip8_aot.h"
+#include "chip8_blit.h"
+#include "chip8_clock.h"
+#include "chip8_jit.h"
+#include "chip8_log.h"
+#include "chip8_render.h"
+#include "chip8_trace.h"
 #include "raylib.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+/* The generated table of the Chip8Op of all the 65536 opcodes. */
+#include "chip8_dispatch.inc"
 
 #define SET_BIT(var, pos) ((var) |= (1 << (pos)))
 #define CLEAR_BIT(var, pos) ((var) &= ~(1 << (pos)))
@@ -28,6 +40,26 @@ const uint8_t font[] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+/* SUPER-CHIP big font, with the A to F digits of XO-CHIP. */
+const uint8_t big_font[] = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
+
 int chip8_init(Chip8 *self) {
   /* Initialize the Chip8 structure with 0. */
   /* TODO Check is this step is necessary. */
@@ -39,14 +71,27 @@ int chip8_init(Chip8 *self) {
    * address 0x0050.
    */
   memcpy(&self->memory[50], font, sizeof(font));
+  memcpy(&self->memory[BIG_FONTSET_START_ADDRESS], big_font, sizeof(big_font));
 
-  for (int i = 50; i <= 80; i++) {
-    printf("Font value: 0x%02x\n", self->memory[i]);
+  if (CHIP8_LOG_ENABLED(CHIP8_LOG_LEVEL_DEBUG)) {
+    for (int i = 50; i <= 80; i++) {
+      CHIP8_LOG_DEBUG("Font value: 0x%02x\n", self->memory[i]);
+    }
   }
 
   /* Load initial value of the PC. */
   self->pc = ENTRY_POINT;
-  printf("The PC is set at the entry point: 0x%04x\n", self->pc);
+  /* Only the first plane is drawn on, until Fn01 selects others. */
+  self->planes = 1;
+  self->pitch = CHIP8_DEFAULT_PITCH;
+  self->timer_rate = CHIP8_CLOCK_DEFAULT_RATE;
+  CHIP8_LOG_DEBUG("The PC is set at the entry point: 0x%04x\n", self->pc);
+
+  chip8_set_profile(self, CHIP8_PROFILE_CHIP8);
+
+  /* Nothing was presented yet, not even the blank screen. */
+  self->dirty_rows = CHIP8_ALL_ROWS;
+  self->presented_hash = ~chip8_frame_hash(self);
 
   return 0;
 }
@@ -60,16 +105,16 @@ int chip8_load_rom(Chip8 *self, char *usr_rom_name) {
 
   /* Set the ROM name to the user's input. */
   self->rom_name = (uint8_t *)usr_rom_name;
-  printf("The loaded rom is %s\n", usr_rom_name);
+  CHIP8_LOG_INFO("The loaded rom is %s\n", usr_rom_name);
 
   /* Open ROM file. */
   FILE *rom = fopen((const char *)self->rom_name, "rb");
 
   /* Check if rom is opened. */
   if (!rom) {
-    fprintf(stderr, "ROM file %s in invalid or doesn't exist!\n",
-            self->rom_name);
-    return false;
+    CHIP8_LOG_ERROR("ROM file %s in invalid or doesn't exist!\n",
+                    self->rom_name);
+    return 1;
   }
 
   fseek(rom, 0, SEEK_END);
@@ -80,10 +125,10 @@ int chip8_load_rom(Chip8 *self, char *usr_rom_name) {
   rewind(rom);
 
   if (rom_size > max_size) {
-    fprintf(stderr,
-            "ROM file %s is too large, and can't fit in memory. %zu is the max "
-            "size, while the rom is %zu bytes.\n",
-            self->rom_name, max_size, rom_size);
+    CHIP8_LOG_ERROR(
+        "ROM file %s is too large, and can't fit in memory. %ld is the max "
+        "size, while the rom is %ld bytes.\n",
+        self->rom_name, max_size, rom_size);
 
     return 1;
   }
@@ -92,54 +137,275 @@ int chip8_load_rom(Chip8 *self, char *usr_rom_name) {
   fread(&(self->memory[ENTRY_POINT]), rom_size, 1, rom);
 
   /* Debugging information. */
-  printf("Dumping memory...\n");
-  for (int i = ENTRY_POINT; i < ENTRY_POINT + rom_size; i++) {
-    if ((i - 0x200) % 15 == 0 && i > 0x200) {
-      printf("\n");
+  if (CHIP8_LOG_ENABLED(CHIP8_LOG_LEVEL_DEBUG)) {
+    CHIP8_LOG_DEBUG("Dumping memory...\n");
+    for (int i = ENTRY_POINT; i < ENTRY_POINT + rom_size; i++) {
+      if ((i - 0x200) % 15 == 0 && i > 0x200) {
+        CHIP8_LOG_DEBUG("\n");
+      }
+      CHIP8_LOG_DEBUG("0x%02x\t", self->memory[i] & 0xff);
     }
-    printf("0x%02x\t", self->memory[i] & 0xff);
+    CHIP8_LOG_DEBUG("\n");
   }
-  printf("\n");
 
   fclose(rom);
 
+  /* Decode the loaded program once, ahead of its execution. */
+  chip8_set_profile(self, chip8_profile_from_name(usr_rom_name));
+
   return 0;
 }
 
+/**
+ * @brief Marks the predecoded instructions that overlap a memory range as stale.
+ *
+ * Must be called whenever an instruction writes to memory, so that the next
+ * fetch of any overwritten instruction decodes it again. The translated blocks
+ * and the recompiled blocks that contain an overwritten instruction are dropped
+ * as well.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param addr The first written address.
+ * @param len The number of written bytes.
+ */
+static void chip8_invalidate(Chip8 *self, uint16_t addr, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    uint16_t index = ((addr + i) & (CHIP8_MEMORY_SIZE - 1)) >> 1;
+
+    self->decoded[index].handler = NULL;
+
+    if (self->jit != NULL) {
+      chip8_jit_invalidate(self, addr + i);
+    }
+
+    if (self->aot != NULL) {
+      chip8_aot_invalidate(self, addr + i);
+    }
+  }
+}
+
+/**
+ * @brief Decodes a 16-bits opcode with the handlers of the current profile.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param op_code The 16-bits opcode to be decoded.
+ * @param inst A pointer to the instruction to be filled.
+ */
+static inline void chip8_decode_profile(const Chip8 *self, uint16_t op_code,
+                                        Chip8Inst *inst) {
+  chip8_decode(op_code, inst);
+  inst->handler = self->handlers[inst->kind];
+}
+
+/**
+ * @brief Looks up the predecoded instruction at an even address.
+ *
+ * The instruction is decoded again first if it was invalidated.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param addr The even address of the instruction.
+ * @return The predecoded instruction.
+ */
+static inline Chip8Inst *chip8_decoded_at(Chip8 *self, uint16_t addr) {
+  Chip8Inst *inst = &self->decoded[addr >> 1];
+
+  if (inst->handler == NULL) {
+    uint16_t op_code = self->memory[addr] << 8 | self->memory[addr + 1];
+    chip8_decode_profile(self, op_code, inst);
+  }
+
+  return inst;
+}
+
+/**
+ * @brief Fetches the predecoded instruction at the PC.
+ *
+ * The function looks up the predecoded instruction at the PC, and then
+ * increments the PC to point to the next instruction. Instructions at odd
+ * addresses are decoded into a scratch entry.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @return The fetched instruction.
+ */
+static inline const Chip8Inst *chip8_fetch(Chip8 *self) {
+  uint16_t old_pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+  const Chip8Inst *inst;
+
+  if (old_pc & 1) {
+    uint16_t op_code = self->memory[old_pc] << 8;
+    op_code |= self->memory[(old_pc + 1) & (CHIP8_MEMORY_SIZE - 1)];
+    chip8_decode_profile(self, op_code, &self->scratch);
+    inst = &self->scratch;
+  } else {
+    inst = chip8_decoded_at(self, old_pc);
+  }
+
+  chip8_trace_record(self, old_pc, inst);
+  self->pc = old_pc + 2;
+
+  return inst;
+}
+
+/**
+ * @brief Skips the instruction at the PC.
+ *
+ * XO-CHIP skips the 4 bytes of F000 nnnn as a whole, which the other profiles
+ * don't have.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+static inline void chip8_skip(Chip8 *self) {
+  uint16_t next = self->pc;
+
+  self->pc = next + 2;
+  if (self->memory[next] == 0xF0 && self->memory[(uint16_t)(next + 1)] == 0 &&
+      self->quirks->xochip) {
+    self->pc = next + 4;
+  }
+}
+
+/**
+ * @brief Checks if a jump closes a loop that can't end before the next timer
+ * tick.
+ *
+ * Two loops are detected: a jump to itself, and a loop that polls the delay
+ * timer with Fx07, then 3xkk or 4xkk on the same Vx, then jumps back to the
+ * Fx07. Neither can change anything until the timer does. The JIT and the
+ * recompiled ROMs leave these jumps to the interpreter, so that they stop with
+ * CHIP8_STOP_IDLE too.
+ *
+ * @param memory The memory of the Chip8 object.
+ * @param addr The address of the jump.
+ * @param target The address the jump goes to.
+ */
+int chip8_idle_jump(const uint8_t *memory, uint16_t addr, uint16_t target) {
+  if (target == addr) {
+    return 1;
+  }
+
+  if (addr != target + 4) {
+    return 0;
+  }
+
+  uint16_t poll = memory[target] << 8 | memory[target + 1];
+  uint16_t skip = memory[target + 2] << 8 | memory[target + 3];
+
+  return (poll & 0xF0FF) == 0xF007 &&
+         ((skip & 0xF000) == 0x3000 || (skip & 0xF000) == 0x4000) &&
+         (skip & 0x0F00) == (poll & 0x0F00);
+}
+
 /**
  * @brief Parses 16-bits Opcode from the memory.
  *
- * The function first parses 8-bits of opcode and then increment the PC to point
- * to the next 8-bits opcode which is then ORed to the previous one to form the
- * 16-bits insturction.
+ * The function fetches the predecoded instruction at the PC, and keeps it to be
+ * executed by chip8_inst_emulate().
  *
  * @param self A pointer to the Chip8 object.
  */
 void chip8_parse_code(Chip8 *self) {
   uint16_t old_pc = self->pc;
-  self->op_code = self->memory[self->pc] << 8;
-  self->pc++;
-  self->op_code |= self->memory[self->pc];
-  self->pc++;
 
-  printf("Address: 0x%04x, opcode: 0x%04x\n", old_pc, self->op_code);
+  self->inst = chip8_fetch(self);
+  self->op_code = self->inst->op_code;
+
+  CHIP8_LOG_TRACE("Address: 0x%04x, opcode: 0x%04x\n", old_pc, self->op_code);
+}
+
+/**
+ * @brief Releases the resources held by the Chip8 object.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_deinit(Chip8 *self) {
+  chip8_jit_free(self);
+  chip8_aot_free(self);
+  chip8_trace_free(self);
+}
+
+/**
+ * @brief Handler of the opcodes that are not implemented.
+ *
+ * Unknown opcodes are ignored, and the execution continues with the next
+ * instruction.
+ *
+ * @param A pointer to the Chip8 object.
+ */
+void Chip8_OP_ignore(Chip8 *self, const Chip8Inst *inst) {}
+
+/**
+ * @brief Handler of the invalid opcodes.
+ *
+ * The execution is halted at the invalid opcode, by pointing the PC back to
+ * it, and the trap is reported once.
+ *
+ * @param A pointer to the Chip8 object.
+ */
+void Chip8_OP_trap(Chip8 *self, const Chip8Inst *inst) {
+  self->pc -= 2;
+  self->stop = CHIP8_STOP_TRAP;
+
+  if (!self->trapped) {
+    CHIP8_LOG_ERROR("Invalid opcode 0x%04x at address 0x%04x.\n", inst->op_code,
+                    self->pc);
+    self->trapped = 1;
+  }
 }
 
 /**
- * TODO To be implemented later.
+ * @brief Scroll the display down by n rows.
+ *
+ * Every column of words of the selected planes is moved down at once, and the
+ * rows at the top are cleared. The rows are the ones of the current resolution.
+ *
+ * @param self A pointer to the Chip8 object.
  */
-void chip8_deinit(Chip8 *self) {}
+void Chip8_OP_00cn(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t n = inst->n;
+  uint8_t height = chip8_screen_height(self);
+
+  for (int p = 0; p < CHIP8_PLANES; p++) {
+    if (!(self->planes & (1 << p))) {
+      continue;
+    }
+
+    for (int w = 0; w < CHIP8_SCREEN_WORDS; w++) {
+      memmove(&self->graphics[p][w][n], &self->graphics[p][w][0],
+              (height - n) * sizeof(uint64_t));
+      memset(&self->graphics[p][w][0], 0, n * sizeof(uint64_t));
+    }
+  }
+
+  self->dirty_rows = CHIP8_ALL_ROWS;
+  self->stop = CHIP8_STOP_DRAW;
+  CHIP8_LOG_TRACE("Scrolled the display down by %d rows.\n", n);
+}
 
 /**
  * @brief Clear the display.
  *
- * The function uses memset() to zero all the graphics array.
+ * The function uses memset() to zero the selected planes of the graphics array,
+ * after marking the rows that weren't blank as dirty.
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_00e0(Chip8 *self) {
-  memset(self->graphics, 0, sizeof(self->graphics));
-  printf("Cleared the display.\n");
+void Chip8_OP_00e0(Chip8 *self, const Chip8Inst *inst) {
+  for (int p = 0; p < CHIP8_PLANES; p++) {
+    if (!(self->planes & (1 << p))) {
+      continue;
+    }
+
+    for (int i = 0; i < CHIP8_HIRES_HEIGHT; i++) {
+      if ((self->graphics[p][0][i] | self->graphics[p][1][i]) != 0) {
+        self->dirty_rows |= 1ULL << i;
+      }
+    }
+
+    memset(self->graphics[p], 0, sizeof(self->graphics[p]));
+  }
+
+  self->stop = CHIP8_STOP_DRAW;
+  CHIP8_LOG_TRACE("Cleared the display.\n");
 }
 
 /**
@@ -151,33 +417,123 @@ void Chip8_OP_00e0(Chip8 *self) {
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_00ee(Chip8 *self) {
+void Chip8_OP_00ee(Chip8 *self, const Chip8Inst *inst) {
   self->sp--;
   /* Restoring context. */
-  self->pc = self->stack[self->sp];
+  self->pc = self->stack[self->sp & 0xf];
 
-  printf("Return from subroutine to address 0x%04x.\n", self->pc);
+  CHIP8_LOG_TRACE("Return from subroutine to address 0x%04x.\n", self->pc);
 }
 
 /**
- * @brief Calls the specified 0xxx intruction.
+ * @brief Scroll the display right by 4 pixels.
  *
- * The function filters the 0xxx opcode by extracting the low nibble and calls
- * the speicified intruction accordingly.
+ * Every row of the selected planes is shifted as a whole, carrying the pixels
+ * from its left word into its right word in the high resolution mode.
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_extract_and_call_0xxx(Chip8 *self) {
-  uint8_t lower_three_nibbles = self->op_code & 0x0fff;
+void Chip8_OP_00fb(Chip8 *self, const Chip8Inst *inst) {
+  for (int p = 0; p < CHIP8_PLANES; p++) {
+    uint64_t(*plane)[CHIP8_HIRES_HEIGHT] = self->graphics[p];
 
-  switch (lower_three_nibbles) {
-  case 0x0e0:
-    Chip8_OP_00e0(self);
-    break;
-  case 0x0ee:
-    Chip8_OP_00ee(self);
-    break;
+    if (!(self->planes & (1 << p))) {
+      continue;
+    }
+
+    if (self->hires) {
+      for (int i = 0; i < CHIP8_HIRES_HEIGHT; i++) {
+        plane[1][i] = (plane[1][i] >> 4) | (plane[0][i] << 60);
+        plane[0][i] >>= 4;
+      }
+    } else {
+      for (int i = 0; i < CHIP8_SCREEN_HEIGHT; i++) {
+        plane[0][i] >>= 4;
+      }
+    }
+  }
+
+  self->dirty_rows = CHIP8_ALL_ROWS;
+  self->stop = CHIP8_STOP_DRAW;
+  CHIP8_LOG_TRACE("Scrolled the display right.\n");
+}
+
+/**
+ * @brief Scroll the display left by 4 pixels.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_00fc(Chip8 *self, const Chip8Inst *inst) {
+  for (int p = 0; p < CHIP8_PLANES; p++) {
+    uint64_t(*plane)[CHIP8_HIRES_HEIGHT] = self->graphics[p];
+
+    if (!(self->planes & (1 << p))) {
+      continue;
+    }
+
+    if (self->hires) {
+      for (int i = 0; i < CHIP8_HIRES_HEIGHT; i++) {
+        plane[0][i] = (plane[0][i] << 4) | (plane[1][i] >> 60);
+        plane[1][i] <<= 4;
+      }
+    } else {
+      for (int i = 0; i < CHIP8_SCREEN_HEIGHT; i++) {
+        plane[0][i] <<= 4;
+      }
+    }
   }
+
+  self->dirty_rows = CHIP8_ALL_ROWS;
+  self->stop = CHIP8_STOP_DRAW;
+  CHIP8_LOG_TRACE("Scrolled the display left.\n");
+}
+
+/**
+ * @brief Exit the interpreter.
+ *
+ * The execution stays at the 00FD, as it does at an invalid opcode.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_00fd(Chip8 *self, const Chip8Inst *inst) {
+  self->pc -= 2;
+  self->stop = CHIP8_STOP_EXIT;
+  CHIP8_LOG_INFO("The program exited at address 0x%04x.\n", self->pc);
+}
+
+/**
+ * @brief Switch to the low or the high resolution mode.
+ *
+ * The whole display is cleared, every plane included, as on the later
+ * SUPER-CHIP and XO-CHIP interpreters.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param hires Set for the 128x64 mode.
+ */
+static void chip8_set_hires(Chip8 *self, uint8_t hires) {
+  self->hires = hires;
+  memset(self->graphics, 0, sizeof(self->graphics));
+  self->dirty_rows = CHIP8_ALL_ROWS;
+  self->stop = CHIP8_STOP_DRAW;
+  CHIP8_LOG_TRACE("Switched to the %s resolution.\n", hires ? "high" : "low");
+}
+
+/**
+ * @brief Switch to the 64x32 low resolution mode.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_00fe(Chip8 *self, const Chip8Inst *inst) {
+  chip8_set_hires(self, 0);
+}
+
+/**
+ * @brief Switch to the 128x64 high resolution mode.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_00ff(Chip8 *self, const Chip8Inst *inst) {
+  chip8_set_hires(self, 1);
 }
 
 /**
@@ -187,13 +543,18 @@ void Chip8_extract_and_call_0xxx(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_1nnn(Chip8 *self) {
-  uint16_t jump_loc = self->op_code & 0x0FFF;
+void Chip8_OP_1nnn(Chip8 *self, const Chip8Inst *inst) {
+  uint16_t jump_loc = inst->nnn;
+
+  if (chip8_idle_jump(self->memory, (self->pc - 2) & (CHIP8_MEMORY_SIZE - 1),
+                      jump_loc)) {
+    self->stop = CHIP8_STOP_IDLE;
+  }
 
   /* Point the the PC to the jump locaton. */
   self->pc = jump_loc;
 
-  printf("Jump to address 0x%04x\n", jump_loc);
+  CHIP8_LOG_TRACE("Jump to address 0x%04x\n", jump_loc);
 }
 
 /**
@@ -204,17 +565,17 @@ void Chip8_OP_1nnn(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_2nnn(Chip8 *self) {
+void Chip8_OP_2nnn(Chip8 *self, const Chip8Inst *inst) {
   /* Push the current PC to the stack. */
-  self->stack[self->sp] = self->pc;
+  self->stack[self->sp & 0xf] = self->pc;
 
   /* Increment the stack pointer (SP). */
   self->sp++;
 
   /* Set the PC to nnn. */
-  self->pc = self->op_code & 0x0FFF;
+  self->pc = inst->nnn;
 
-  printf("Jump to 0x%04x\n", self->pc);
+  CHIP8_LOG_TRACE("Jump to 0x%04x\n", self->pc);
 }
 
 /**
@@ -225,16 +586,17 @@ void Chip8_OP_2nnn(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_3xkk(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t kk = self->op_code & 0x00FF;
+void Chip8_OP_3xkk(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t kk = inst->kk;
 
   if (self->registers[Vx] == kk) {
-    self->pc += 2;
+    chip8_skip(self);
   }
 
-  printf("Checking if Vx = kk, 0x%04x 0x%04x, skip next instruction if true.\n",
-         self->registers[Vx], kk);
+  CHIP8_LOG_TRACE(
+      "Checking if Vx = kk, 0x%04x 0x%04x, skip next instruction if true.\n",
+      self->registers[Vx], kk);
 }
 
 /**
@@ -245,15 +607,15 @@ void Chip8_OP_3xkk(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_4xkk(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t kk = self->op_code & 0x00FF;
+void Chip8_OP_4xkk(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t kk = inst->kk;
 
   if (self->registers[Vx] != kk) {
-    self->pc += 2;
+    chip8_skip(self);
   }
 
-  printf(
+  CHIP8_LOG_TRACE(
       "Checking if Vx != kk, 0x%04x 0x%04x, skip next instruction if true.\n",
       self->registers[Vx], kk);
 }
@@ -266,16 +628,55 @@ void Chip8_OP_4xkk(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_5xy0(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_5xy0(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   if (self->registers[Vx] == self->registers[Vy]) {
-    self->pc += 2;
+    chip8_skip(self);
+  }
+
+  CHIP8_LOG_TRACE(
+      "Checking if Vx = Vy, 0x%04x 0x%04x, skip next instruction if true.\n",
+      self->registers[Vx], self->registers[Vy]);
+}
+
+/**
+ * @brief Store registers Vx through Vy in memory starting at location I.
+ *
+ * The registers are stored in reverse order if x is greater than y, and I is
+ * left unchanged.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_5xy2(Chip8 *self, const Chip8Inst *inst) {
+  int8_t step = inst->x <= inst->y ? 1 : -1;
+  uint8_t count = abs(inst->y - inst->x) + 1;
+
+  for (uint8_t i = 0; i < count; i++) {
+    self->memory[(uint16_t)(self->ir + i)] =
+        self->registers[inst->x + i * step];
   }
 
-  printf("Checking if Vx = Vy, 0x%04x 0x%04x, skip next instruction if true.\n",
-         self->registers[Vx], self->registers[Vy]);
+  chip8_invalidate(self, self->ir, count);
+}
+
+/**
+ * @brief Read registers Vx through Vy from memory starting at location I.
+ *
+ * The registers are read in reverse order if x is greater than y, and I is
+ * left unchanged.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_5xy3(Chip8 *self, const Chip8Inst *inst) {
+  int8_t step = inst->x <= inst->y ? 1 : -1;
+  uint8_t count = abs(inst->y - inst->x) + 1;
+
+  for (uint8_t i = 0; i < count; i++) {
+    self->registers[inst->x + i * step] =
+        self->memory[(uint16_t)(self->ir + i)];
+  }
 }
 
 /**
@@ -285,13 +686,13 @@ void Chip8_OP_5xy0(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_6xkk(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t kk = self->op_code & 0x00FF;
+void Chip8_OP_6xkk(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t kk = inst->kk;
 
   self->registers[Vx] = kk;
 
-  printf("Setting register Vx to value 0x%04x\n", kk);
+  CHIP8_LOG_TRACE("Setting register Vx to value 0x%04x\n", kk);
 }
 
 /**
@@ -301,14 +702,14 @@ void Chip8_OP_6xkk(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_7xkk(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t kk = self->op_code & 0x00FF;
+void Chip8_OP_7xkk(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t kk = inst->kk;
 
   self->registers[Vx] += kk;
 
-  printf("Register Vx 0x%04x + Value kk 0x%04x = 0x%04x.\n",
-         self->registers[Vx] - kk, kk, self->registers[Vx]);
+  CHIP8_LOG_TRACE("Register Vx 0x%04x + Value kk 0x%04x = 0x%04x.\n",
+                  self->registers[Vx] - kk, kk, self->registers[Vx]);
 }
 
 /**
@@ -319,17 +720,18 @@ void Chip8_OP_7xkk(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_9xy0(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_9xy0(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   if (self->registers[Vx] != self->registers[Vy]) {
-    self->pc += 2;
+    chip8_skip(self);
   }
 
-  printf("Checking if register Vx 0x%04x != register Vy 0x%04x, skip the next "
-         "insturction if true.\n",
-         self->registers[Vx], self->registers[Vy]);
+  CHIP8_LOG_TRACE(
+      "Checking if register Vx 0x%04x != register Vy 0x%04x, skip the next "
+      "insturction if true.\n",
+      self->registers[Vx], self->registers[Vy]);
 }
 
 /**
@@ -339,25 +741,10 @@ void Chip8_OP_9xy0(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_annn(Chip8 *self) {
-  self->ir = self->op_code & 0x0FFF;
-
-  printf("Setting the Index register to 0x%04x.\n", self->ir);
-}
-
-/**
- * @brief Jump to location nnn + V0.
- *
- * The program counter is set to nnn plus the value of V0.
- *
- * @param self A pointer to the Chip8 object.
- */
-void Chip8_OP_bnnn(Chip8 *self) {
-  uint16_t tmp = self->op_code & 0x0FFF;
+void Chip8_OP_annn(Chip8 *self, const Chip8Inst *inst) {
+  self->ir = inst->nnn;
 
-  self->pc = tmp + self->registers[V0];
-
-  printf("Jumping to location 0x%04x.\n", self->pc);
+  CHIP8_LOG_TRACE("Setting the Index register to 0x%04x.\n", self->ir);
 }
 
 /**
@@ -369,95 +756,16 @@ void Chip8_OP_bnnn(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_cxkk(Chip8 *self) {
-  uint8_t tmp = self->op_code & 0x00FF;
+void Chip8_OP_cxkk(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t tmp = inst->kk;
   uint8_t random_byte = (uint8_t)GetRandomValue(0, 255);
 
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+  uint8_t Vx = inst->x;
 
   self->registers[Vx] = random_byte & tmp;
 
-  printf("Setting the register Vx 0x%04x = 0x%04x & 0x%04x.\n",
-         self->registers[Vx], random_byte, tmp);
-}
-
-/**
- * @brief  Display n-byte sprite starting at memory location I at (Vx, Vy), set
- * VF = collision.
- *
- *  The interpreter reads n bytes from memory, starting at the address stored in
- * I. These bytes are then displayed as sprites on screen at coordinates (Vx,
- * Vy). Sprites are XORed onto the existing screen. If this causes any pixels to
- * be erased, VF is set to 1, otherwise it is set to 0. If the sprite is
- * positioned so part of it is outside the coordinates of the display, it wraps
- * around to the opposite side of the screen. See instruction 8xy3 for more
- * information on XOR, and section 2.4, Display, for more information on the
- * Chip-8 screen and sprites.
- *
- * @param self A pointer to the Chip8 object.
- */
-void Chip8_OP_dxyn(Chip8 *self) {
-  /* Number of bytes to be read from memory. */
-  uint8_t num_of_bytes = GET_NIBBLE(self->op_code, 0);
-
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
-
-  uint8_t x_cord = self->registers[Vx] % CHIP8_SCREEN_WIDTH;
-  uint8_t y_cord = self->registers[Vy] % CHIP8_SCREEN_HEIGHT;
-
-  printf("The coordinates are (%d, %d)\n", self->registers[Vx],
-         self->registers[Vy]);
-
-  self->registers[VF] = 0;
-
-  uint8_t sprite = 0;
-  uint8_t x_current;
-  uint8_t y_current;
-
-  for (uint8_t y_offset = 0; y_offset < num_of_bytes; y_offset++) {
-    sprite = self->memory[self->ir + y_offset];
-    printf("The loaded sprite is 0x%04X\n", sprite);
-
-    for (int x_offset = 0; x_offset < 8; x_offset++) {
-      x_current = x_cord + x_offset;
-      y_current = y_cord + y_offset;
-      printf("The current coordinates (%d, %d)\n", x_current, y_current);
-
-      uint8_t screen_bit = self->graphics[x_current][y_current];
-      printf("The current state of the screen is %d\n", screen_bit);
-
-      uint8_t sprite_bit = (sprite & (0x80 >> x_offset)) >> (7 - x_offset);
-      printf("The current sprite bit is %x\n", sprite_bit);
-      if (sprite_bit == 1) {
-        if (screen_bit == 1) {
-          self->registers[VF] = 1;
-        }
-        self->graphics[x_current][y_current] ^= 1;
-      }
-    }
-  }
-
-  /* int x = 0; */
-  /* int y = 0; */
-  /* printf("Dumping the graphics:\n"); */
-  /* for (int i = 0; i < CHIP8_SCREEN_WIDTH; i++) { */
-  /*   for (int j = 0; j < CHIP8_SCREEN_HEIGHT; j++) { */
-  /*     printf("0x%04x\t", self->graphics[i][j]); */
-  /*     y++; */
-  /*     if (y == 8) { */
-  /*     printf("\n"); */
-  /*     y = 0; */
-  /*     } */
-  /*   } */
-  /*   x++; */
-  /*   if (x == 8) { */
-  /*     printf("\n"); */
-  /*     x = 0; */
-  /*   } */
-  /* } */
-//  printf("\n");
-  printf("Drawing.\n");
+  CHIP8_LOG_TRACE("Setting the register Vx 0x%04x = 0x%04x & 0x%04x.\n",
+                  self->registers[Vx], random_byte, tmp);
 }
 
 /**
@@ -466,74 +774,17 @@ void Chip8_OP_dxyn(Chip8 *self) {
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_8xy0(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_8xy0(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   self->registers[Vx] = self->registers[Vy];
 
-  printf(
+  CHIP8_LOG_TRACE(
       "Setting the register Vx 0x%04x to be the same as register Vy 0x%04x\n.",
       self->registers[Vx], self->registers[Vy]);
 }
 
-/**
- * @brief Set Vx = Vx OR Vy
- *
- * Performs a bitwise OR on the values of Vx and Vy, the stores the
- * result in Vx.
- *
- * @param A pointer to the Chip8 object.
- */
-void Chip8_OP_8xy1(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
-
-  uint8_t tmp = self->registers[Vx];
-
-  self->registers[Vx] |= self->registers[Vy];
-
-  printf("Setting the register Vx 0x%04x to be Vx 0x%04x | Vy 0x%04x\n.",
-         self->registers[Vx], tmp, self->registers[Vy]);
-}
-
-/**
- * @brief Set Vx = Vx AND Vy
- *
- * Performs a bitwise AND on the values of Vx and Vy, then stores the
- * result in Vx.
- *
- * @param A pointer to the Chip8 object.
- */
-void Chip8_OP_8xy2(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
-
-  uint8_t tmp = self->registers[Vx];
-
-  self->registers[Vx] &= self->registers[Vy];
-
-  printf("Setting the register Vx 0x%04x to be Vx 0x%04x & Vy 0x%04x.\n",
-         self->registers[Vx], tmp, self->registers[Vy]);
-}
-
-/**
- * @brief Set Vx = Vx XOR Vy.
- *
- * Performs a bitwise exclusive OR on the values of Vx and Vy, then
- * stores the result in Vx.
- *
- * @param A pointer to the Chip8 object.
- */
-void Chip8_OP_8xy3(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
-
-  self->registers[Vx] ^= self->registers[Vy];
-
-  printf("XORing register Vx, with register Vy\n.");
-}
-
 /**
  * @brief Set Vx = Vx + Vy, set VF = carry.
  *
@@ -542,9 +793,9 @@ void Chip8_OP_8xy3(Chip8 *self) {
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_8xy4(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_8xy4(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   uint16_t tmp = self->registers[Vx] + self->registers[Vy];
 
@@ -556,7 +807,7 @@ void Chip8_OP_8xy4(Chip8 *self) {
     self->registers[VF] = 0;
   }
 
-  printf("Setting Vx += Vy.\n");
+  CHIP8_LOG_TRACE("Setting Vx += Vy.\n");
 }
 
 /**
@@ -567,9 +818,9 @@ void Chip8_OP_8xy4(Chip8 *self) {
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_8xy5(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_8xy5(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   uint8_t tmp = self->registers[Vx];
 
@@ -581,176 +832,102 @@ void Chip8_OP_8xy5(Chip8 *self) {
     self->registers[VF] = 0;
   }
 
-  printf("Setting Vx -= Vy.\n");
+  CHIP8_LOG_TRACE("Setting Vx -= Vy.\n");
 }
 
 /**
- * @brief Set Vx = Vx SHR 1.
+ * @brief  Set Vx = Vy - Vx, set VF = NOT borrow.
  *
- * If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0.
- * Then Vx is divided by 2.
+ * If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy,
+ * and the results stored in Vx.
  *
  * @param A pointer to the Chip8 object.
  */
-void Chip8_OP_8xy6(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_8xy7(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  uint8_t Vy = inst->y;
 
   uint8_t tmp = self->registers[Vx];
 
-  self->registers[Vx] /= 2;
+  self->registers[Vx] = self->registers[Vy] - self->registers[Vx];
 
-    if ((tmp & 0x1) == 1) {
+  if (self->registers[Vy] > tmp) {
     self->registers[VF] = 1;
   } else {
     self->registers[VF] = 0;
   }
 
-  printf("Setting Vx SHR 1.\n");
+  CHIP8_LOG_TRACE("Subtracting Vx from Vy.\n");
 }
 
 /**
- * @brief  Set Vx = Vy - Vx, set VF = NOT borrow.
+ * @brief Skip next instruction if key with the value of Vx is not pressed.
  *
- * If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy,
- * and the results stored in Vx.
+ * Checks the keyboard, and if the key corresponding to the value of Vx is
+ * currently in the up position, PC is increased by 2.
  *
- * @param A pointer to the Chip8 object.
+ * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_8xy7(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t Vy = GET_NIBBLE(self->op_code, Y_NIBBLE);
+void Chip8_OP_exa1(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
 
-  uint8_t tmp = self->registers[Vx];
-
-  self->registers[Vx] = self->registers[Vy] - self->registers[Vx];
-
-  if (self->registers[Vy] > tmp) {
-    self->registers[VF] = 1;
-  } else {
-    self->registers[VF] = 0;
+  if (self->keypad[self->registers[Vx] & 0xf] == 0) {
+    chip8_skip(self);
   }
-
-  printf("Subtracting Vx from Vy.\n");
 }
 
 /**
- * @brief  Set Vx = Vx SHL 1.
+ * @brief  Skip next instruction if key with the value of Vx is pressed.
  *
- * If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0.
- * Then Vx is multiplied by 2.
+ * Checks the keyboard, and if the key corresponding to the value of Vx is
+ * currently in the down position, PC is increased by 2.
  *
- * @param A pointer to the Chip8 object.
+ * @param self A pointer to to the Chip8 object.
  */
-void Chip8_OP_8xye(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-
-  uint8_t tmp = self->registers[Vx];
-
-  self->registers[Vx] *= 2;
+void Chip8_OP_ex9e(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
 
-  if (((tmp & 0xf) >> 3) == 1) {
-    self->registers[VF] = 1;
-  } else {
-    self->registers[VF] = 0;
+  if (self->keypad[self->registers[Vx] & 0xf] == 1) {
+    chip8_skip(self);
   }
-
-  printf("Multiplying Vx * 2.\n");
 }
 
 /**
- * @brief Calls the specified 8xxx intruction.
+ * @brief Set I = nnnn, the 16-bit address that follows the instruction.
  *
- * The function filters the 8xxx opcode by extracting the low nibble and calls
- * the speicified intruction accordingly.
+ * The address is read from memory rather than decoded, and the PC is moved
+ * past it.
  *
  * @param self A pointer to the Chip8 object.
- *
  */
-void Chip8_extract_and_call_8xxx(Chip8 *self) {
-  uint8_t low_nibble = GET_NIBBLE(self->op_code, 0);
+void Chip8_OP_f000(Chip8 *self, const Chip8Inst *inst) {
+  self->ir = self->memory[self->pc] << 8 |
+             self->memory[(uint16_t)(self->pc + 1)];
+  self->pc += 2;
 
-  switch (low_nibble) {
-  case 0x0:
-    Chip8_OP_8xy0(self);
-    break;
-  case 0x1:
-    Chip8_OP_8xy1(self);
-    break;
-  case 0x2:
-    Chip8_OP_8xy2(self);
-    break;
-  case 0x3:
-    Chip8_OP_8xy3(self);
-    break;
-  case 0x4:
-    Chip8_OP_8xy4(self);
-    break;
-  case 0x5:
-    Chip8_OP_8xy5(self);
-    break;
-  case 0x6:
-    Chip8_OP_8xy6(self);
-    break;
-  case 0x7:
-    Chip8_OP_8xy7(self);
-    break;
-  case 0xE:
-    Chip8_OP_8xye(self);
-    break;
-  }
+  CHIP8_LOG_TRACE("Setting the IR to the long address 0x%04x.\n", self->ir);
 }
 
 /**
- * @brief Skip next instruction if key with the value of Vx is not pressed.
+ * @brief Select the planes drawn on by 00E0, 00Cn, 00FB, 00FC and Dxyn.
  *
- * Checks the keyboard, and if the key corresponding to the value of Vx is
- * currently in the up position, PC is increased by 2.
+ * The n of Fn01 is a mask of the planes, with the first plane in bit 0.
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_exa1(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-
-  if (self->keypad[self->registers[Vx] & 0xf] == 0) {
-    self->pc += 2;
-  }
-}
-
-/**
- * @brief  Skip next instruction if key with the value of Vx is pressed.
- *
- * Checks the keyboard, and if the key corresponding to the value of Vx is
- * currently in the down position, PC is increased by 2.
- *
- * @param self A pointer to to the Chip8 object.
- */
-void Chip8_OP_ex9e(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-
-  if (self->keypad[self->registers[Vx] & 0xf] == 1) {
-    self->pc += 2;
-  }
+void Chip8_OP_fn01(Chip8 *self, const Chip8Inst *inst) {
+  self->planes = inst->x;
+  CHIP8_LOG_TRACE("Selected the planes 0x%x.\n", self->planes);
 }
 
 /**
- * @brief Calls the specified exxx intruction.
- *
- * The function filters the exxx opcode by extracting the low nibble and calls
- * the speicified intruction accordingly.
+ * @brief Load the audio pattern from memory starting at location I.
  *
  * @param self A pointer to the Chip8 object.
- *
  */
-void Chip8_extract_and_call_exxx(Chip8 *self) {
-  uint8_t lower_byte = self->op_code & 0x00ff;
-
-  switch (lower_byte) {
-  case 0xa1:
-    Chip8_OP_exa1(self);
-    break;
-  case 0x9e:
-    Chip8_OP_ex9e(self);
-    break;
+void Chip8_OP_f002(Chip8 *self, const Chip8Inst *inst) {
+  for (uint8_t i = 0; i < CHIP8_AUDIO_PATTERN_SIZE; i++) {
+    self->audio_pattern[i] = self->memory[(uint16_t)(self->ir + i)];
   }
 }
 
@@ -761,10 +938,10 @@ void Chip8_extract_and_call_exxx(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx07(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx07(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
 
-  self->registers[Vx] = self->delay_timer;
+  self->registers[Vx] = chip8_delay_timer(self);
 }
 
 /**
@@ -775,22 +952,21 @@ void Chip8_OP_fx07(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx0a(Chip8 *self) {
-  printf("Entering the keypad checking function.\n");
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  self->registers[Vx] = 0;
+void Chip8_OP_fx0a(Chip8 *self, const Chip8Inst *inst) {
+  CHIP8_LOG_TRACE("Entering the keypad checking function.\n");
+  uint8_t Vx = inst->x;
 
-  uint8_t i;
-  for (i = 0; i <= 15; i++) {
+  for (uint8_t i = 0; i <= 15; i++) {
     if (self->keypad[i] == 1) {
-      printf("A KEY WAS PRESSED.\n");
+      CHIP8_LOG_TRACE("A KEY WAS PRESSED.\n");
       self->registers[Vx] = i;
-      break;
-    } else {
-      printf("NO KEY FOUND.\n");
-      self->pc -= 2;
+      return;
     }
   }
+
+  /* No key is pressed, so this instruction is executed again. */
+  self->pc -= 2;
+  self->stop = CHIP8_STOP_WAIT_KEY;
 }
 
 /**
@@ -800,9 +976,10 @@ void Chip8_OP_fx0a(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx15(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx15(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
   self->delay_timer = self->registers[Vx];
+  self->delay_tick = chip8_timer_ticks(self);
 }
 
 /**
@@ -812,9 +989,10 @@ void Chip8_OP_fx15(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx18(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx18(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
   self->sound_timer = self->registers[Vx];
+  self->sound_tick = chip8_timer_ticks(self);
 }
 
 /**
@@ -824,8 +1002,8 @@ void Chip8_OP_fx18(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx1e(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx1e(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
   self->ir += self->registers[Vx];
 }
 
@@ -839,12 +1017,27 @@ void Chip8_OP_fx1e(Chip8 *self) {
  *
  * TODO Make sure that this function operates correctly.
  */
-void Chip8_OP_fx29(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx29(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
   self->ir = ((self->registers[Vx] & 0xf) * 5) + FONTSET_START_ADDRESS;
 
-  printf("Setting the IR to 0x%04x as the value of the Vx is 0x%04x.\n",
-         self->ir, self->registers[Vx]);
+  CHIP8_LOG_TRACE(
+      "Setting the IR to 0x%04x as the value of the Vx is 0x%04x.\n",
+      self->ir, self->registers[Vx]);
+}
+
+/**
+ * @brief Set I = location of the big sprite for digit Vx.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_fx30(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
+  self->ir =
+      ((self->registers[Vx] & 0xf) * BIG_FONT_SIZE) + BIG_FONTSET_START_ADDRESS;
+
+  CHIP8_LOG_TRACE("Setting the IR to the big digit 0x%x.\n",
+                  self->registers[Vx] & 0xf);
 }
 
 /**
@@ -856,256 +1049,985 @@ void Chip8_OP_fx29(Chip8 *self) {
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx33(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
+void Chip8_OP_fx33(Chip8 *self, const Chip8Inst *inst) {
+  uint8_t Vx = inst->x;
   uint8_t tmp_value = self->registers[Vx];
 
   /* Ones places */
-  self->memory[self->ir + 2] = tmp_value % 10;
+  self->memory[(uint16_t)(self->ir + 2)] = tmp_value % 10;
   tmp_value /= 10;
 
   /* Tens place */
-  self->memory[self->ir + 1] = tmp_value % 10;
+  self->memory[(uint16_t)(self->ir + 1)] = tmp_value % 10;
   tmp_value /= 10;
 
   /* Hundreds place */
   self->memory[self->ir] = tmp_value % 10;
+
+  chip8_invalidate(self, self->ir, 3);
 }
 
 /**
- * @brief Store registers V0 through Vx in memory starting at location I.
+ * @brief Set the pitch of the audio pattern = Vx.
  *
- * The interpreter copies the values of registers V0 through Vx into memory,
- * starting at the address in I.
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_fx3a(Chip8 *self, const Chip8Inst *inst) {
+  self->pitch = self->registers[inst->x];
+}
+
+/**
+ * @brief Store registers V0 through Vx in the flag registers.
  *
  * @param self A pointer to the Chip8 object.
  */
-void Chip8_OP_fx55(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t i = 0;
+void Chip8_OP_fx75(Chip8 *self, const Chip8Inst *inst) {
+  memcpy(self->flags, self->registers, inst->x + 1);
+  CHIP8_LOG_TRACE("Saved V0 to V%X in the flags.\n", inst->x);
+}
 
-  for (i = 0; i <= Vx; i++) {
-    self->memory[self->ir + i] = self->registers[i];
-  }
+/**
+ * @brief Read registers V0 through Vx from the flag registers.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void Chip8_OP_fx85(Chip8 *self, const Chip8Inst *inst) {
+  memcpy(self->registers, self->flags, inst->x + 1);
+  CHIP8_LOG_TRACE("Loaded V0 to V%X from the flags.\n", inst->x);
 }
 
+/* The handlers that are the same in every profile. */
+#define CHIP8_COMMON_HANDLERS                                                  \
+  [CHIP8_OP_IGNORE] = Chip8_OP_ignore,                                         \
+  [CHIP8_OP_TRAP] = Chip8_OP_trap,                                             \
+  [CHIP8_OP_00E0] = Chip8_OP_00e0,                                             \
+  [CHIP8_OP_00EE] = Chip8_OP_00ee,                                             \
+  [CHIP8_OP_1NNN] = Chip8_OP_1nnn,                                             \
+  [CHIP8_OP_2NNN] = Chip8_OP_2nnn,                                             \
+  [CHIP8_OP_3XKK] = Chip8_OP_3xkk,                                             \
+  [CHIP8_OP_4XKK] = Chip8_OP_4xkk,                                             \
+  [CHIP8_OP_5XY0] = Chip8_OP_5xy0,                                             \
+  [CHIP8_OP_6XKK] = Chip8_OP_6xkk,                                             \
+  [CHIP8_OP_7XKK] = Chip8_OP_7xkk,                                             \
+  [CHIP8_OP_8XY0] = Chip8_OP_8xy0,                                             \
+  [CHIP8_OP_8XY4] = Chip8_OP_8xy4,                                             \
+  [CHIP8_OP_8XY5] = Chip8_OP_8xy5,                                             \
+  [CHIP8_OP_8XY7] = Chip8_OP_8xy7,                                             \
+  [CHIP8_OP_9XY0] = Chip8_OP_9xy0,                                             \
+  [CHIP8_OP_ANNN] = Chip8_OP_annn,                                             \
+  [CHIP8_OP_CXKK] = Chip8_OP_cxkk,                                             \
+  [CHIP8_OP_EX9E] = Chip8_OP_ex9e,                                             \
+  [CHIP8_OP_EXA1] = Chip8_OP_exa1,                                             \
+  [CHIP8_OP_FX07] = Chip8_OP_fx07,                                             \
+  [CHIP8_OP_FX0A] = Chip8_OP_fx0a,                                             \
+  [CHIP8_OP_FX15] = Chip8_OP_fx15,                                             \
+  [CHIP8_OP_FX18] = Chip8_OP_fx18,                                             \
+  [CHIP8_OP_FX1E] = Chip8_OP_fx1e,                                             \
+  [CHIP8_OP_FX29] = Chip8_OP_fx29,                                             \
+  [CHIP8_OP_FX33] = Chip8_OP_fx33
+
+/* The handlers of the SUPER-CHIP instructions, in the profiles that have
+ * them. */
+#define CHIP8_SUPERCHIP_HANDLERS                                               \
+  [CHIP8_OP_00CN] = Chip8_OP_00cn,                                             \
+  [CHIP8_OP_00FB] = Chip8_OP_00fb,                                             \
+  [CHIP8_OP_00FC] = Chip8_OP_00fc,                                             \
+  [CHIP8_OP_00FD] = Chip8_OP_00fd,                                             \
+  [CHIP8_OP_00FE] = Chip8_OP_00fe,                                             \
+  [CHIP8_OP_00FF] = Chip8_OP_00ff,                                             \
+  [CHIP8_OP_FX30] = Chip8_OP_fx30,                                             \
+  [CHIP8_OP_FX75] = Chip8_OP_fx75,                                             \
+  [CHIP8_OP_FX85] = Chip8_OP_fx85
+
+/* The handlers of the XO-CHIP instructions, in the profile that has them. */
+#define CHIP8_XOCHIP_HANDLERS                                                  \
+  [CHIP8_OP_5XY2] = Chip8_OP_5xy2,                                             \
+  [CHIP8_OP_5XY3] = Chip8_OP_5xy3,                                             \
+  [CHIP8_OP_F000] = Chip8_OP_f000,                                             \
+  [CHIP8_OP_FN01] = Chip8_OP_fn01,                                             \
+  [CHIP8_OP_F002] = Chip8_OP_f002,                                             \
+  [CHIP8_OP_FX3A] = Chip8_OP_fx3a
+
+#define QUIRK_PROFILE chip8
+#define QUIRK_SHIFT_VY 1
+#define QUIRK_LOAD_STORE_INC 1
+#define QUIRK_JUMP_VX 0
+#define QUIRK_VF_RESET 1
+#define QUIRK_CLIP 1
+#define QUIRK_SPRITE16 0
+#define QUIRK_SUPERCHIP 0
+#define QUIRK_XOCHIP 0
+#include "chip8_quirks.inc"
+
+#define QUIRK_PROFILE schip
+#define QUIRK_SHIFT_VY 0
+#define QUIRK_LOAD_STORE_INC 0
+#define QUIRK_JUMP_VX 1
+#define QUIRK_VF_RESET 0
+#define QUIRK_CLIP 1
+#define QUIRK_SPRITE16 1
+#define QUIRK_SUPERCHIP 1
+#define QUIRK_XOCHIP 0
+#include "chip8_quirks.inc"
+
+#define QUIRK_PROFILE xochip
+#define QUIRK_SHIFT_VY 1
+#define QUIRK_LOAD_STORE_INC 1
+#define QUIRK_JUMP_VX 0
+#define QUIRK_VF_RESET 0
+#define QUIRK_CLIP 0
+#define QUIRK_SPRITE16 1
+#define QUIRK_SUPERCHIP 1
+#define QUIRK_XOCHIP 1
+#include "chip8_quirks.inc"
+
+/* The specialized handlers of every profile. */
+static const function *const chip8_profile_handlers[CHIP8_PROFILE_COUNT] = {
+    [CHIP8_PROFILE_CHIP8] = chip8_handlers_chip8,
+    [CHIP8_PROFILE_SCHIP] = chip8_handlers_schip,
+    [CHIP8_PROFILE_XOCHIP] = chip8_handlers_xochip,
+};
+
+/* The quirks of every profile. */
+static const Chip8Quirks *const chip8_profile_quirks[CHIP8_PROFILE_COUNT] = {
+    [CHIP8_PROFILE_CHIP8] = &chip8_quirks_chip8,
+    [CHIP8_PROFILE_SCHIP] = &chip8_quirks_schip,
+    [CHIP8_PROFILE_XOCHIP] = &chip8_quirks_xochip,
+};
+
 /**
- * @brief Read registers V0 through Vx from memory starting at location I.
+ * @brief Decodes a 16-bits opcode into a predecoded instruction.
  *
- * The interpreter reads values from memory starting at location I into
- * registers V0 through Vx.
+ * The function resolves the final handler of the opcode with a single lookup
+ * in the generated dispatch table, and extracts all its operands once, so that
+ * the handlers don't have to extract them on every execution. The handler is
+ * the one of the CHIP-8 profile; use chip8_decode_profile() to get the one of
+ * the profile of a Chip8 object.
  *
- * @param self A pointer to the Chip8 object.
+ * @param op_code The 16-bits opcode to be decoded.
+ * @param inst A pointer to the instruction to be filled.
  */
-void Chip8_OP_fx65(Chip8 *self) {
-  uint8_t Vx = GET_NIBBLE(self->op_code, X_NIBBLE);
-  uint8_t i;
+void chip8_decode(uint16_t op_code, Chip8Inst *inst) {
+  inst->op_code = op_code;
+  inst->nnn = op_code & 0x0FFF;
+  inst->x = GET_NIBBLE(op_code, X_NIBBLE);
+  inst->y = GET_NIBBLE(op_code, Y_NIBBLE);
+  inst->n = GET_NIBBLE(op_code, 0);
+  inst->kk = op_code & 0x00FF;
+
+  inst->kind = chip8_dispatch[op_code];
+  inst->handler = chip8_handlers_chip8[inst->kind];
+}
 
-  for (i = 0; i <= Vx; i++) {
-    self->registers[i] = self->memory[self->ir + i];
+/**
+ * @brief Selects the quirks the instructions are executed with.
+ *
+ * Every profile has its own specialized handlers, so the quirks are never
+ * checked while executing. The whole memory is decoded again with the
+ * handlers of the new profile.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param profile The Chip8Profile to be used.
+ */
+void chip8_set_profile(Chip8 *self, Chip8Profile profile) {
+  if (profile >= CHIP8_PROFILE_COUNT) {
+    profile = CHIP8_PROFILE_CHIP8;
   }
+
+  self->profile = profile;
+  self->handlers = chip8_profile_handlers[profile];
+  self->quirks = chip8_profile_quirks[profile];
+
+  chip8_decode_memory(self);
 }
 
-void Chip8_extract_and_call_fxxx(Chip8 *self) {
-  uint8_t low_byte = GET_NIBBLE(self->op_code, 1) << 4;
-  low_byte |= GET_NIBBLE(self->op_code, 0);
+/**
+ * @brief Guesses the profile of a ROM from the extension of its file name.
+ *
+ * ROMs ending in .sc8 are SUPER-CHIP ROMs, the ones ending in .xo8 are XO-CHIP
+ * ROMs, and all the others are CHIP-8 ROMs.
+ *
+ * @param rom_name The file name of the ROM.
+ */
+Chip8Profile chip8_profile_from_name(const char *rom_name) {
+  const char *ext = strrchr(rom_name, '.');
 
-  switch (low_byte) {
-  case 0x07:
-    printf("Calling function fx07.\n");
-    Chip8_OP_fx07(self);
-    break;
-  case 0x0A:
-    printf("Calling function fx0A.\n");
-    Chip8_OP_fx0a(self);
-    break;
-  case 0x15:
-    printf("Calling function fx15.\n");
-    Chip8_OP_fx15(self);
-    break;
-  case 0x18:
-    printf("Calling function fx18.\n");
-    Chip8_OP_fx18(self);
-    break;
-  case 0x1e:
-    printf("Calling function fx1e.\n");
-    Chip8_OP_fx1e(self);
-    break;
-  case 0x29:
-    printf("Calling function fx29.\n");
-    Chip8_OP_fx29(self);
-    break;
-  case 0x33:
-    printf("Calling function fx33.\n");
-    Chip8_OP_fx33(self);
-    break;
-  case 0x55:
-    printf("Calling function fx55.\n");
-    Chip8_OP_fx55(self);
-    break;
-  case 0x65:
-    printf("Calling function fx65.\n");
-    Chip8_OP_fx65(self);
-    break;
+  if (ext != NULL && strcasecmp(ext, ".sc8") == 0) {
+    return CHIP8_PROFILE_SCHIP;
+  }
+  if (ext != NULL && strcasecmp(ext, ".xo8") == 0) {
+    return CHIP8_PROFILE_XOCHIP;
   }
+
+  return CHIP8_PROFILE_CHIP8;
 }
 
-/* Array of function pointers, for the Chip-8 opcode. */
-function chip8_instructions[16] = {Chip8_extract_and_call_0xxx,
-                                   Chip8_OP_1nnn,
-                                   Chip8_OP_2nnn,
-                                   Chip8_OP_3xkk,
-                                   Chip8_OP_4xkk,
-                                   Chip8_OP_5xy0,
-                                   Chip8_OP_6xkk,
-                                   Chip8_OP_7xkk,
-                                   Chip8_extract_and_call_8xxx,
-                                   Chip8_OP_9xy0,
-                                   Chip8_OP_annn,
-                                   Chip8_OP_bnnn,
-                                   Chip8_OP_cxkk,
-                                   Chip8_OP_dxyn,
-                                   Chip8_extract_and_call_exxx,
-                                   Chip8_extract_and_call_fxxx};
+/**
+ * @brief Builds the predecoded instruction cache of the whole memory.
+ *
+ * Every even address of the memory gets its own entry, so that fetching an
+ * instruction becomes a single lookup. Any translated block or recompiled ROM
+ * is dropped.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_decode_memory(Chip8 *self) {
+  for (uint32_t addr = 0; addr < CHIP8_MEMORY_SIZE; addr += 2) {
+    uint16_t op_code = self->memory[addr] << 8 | self->memory[addr + 1];
+    chip8_decode_profile(self, op_code, &self->decoded[addr >> 1]);
+  }
+
+  chip8_jit_free(self);
+  chip8_aot_free(self);
+}
 
 /**
  * @brief The main emulation function that is being called to execute the Chip-8 opcdoe.
  *
- * This function executes the opcode by:
- * 1. Calling the array of function pointer.
- * 2. Executing the function the corresponds to the extracted nibble from the opcode.
+ * This function executes the opcode by calling the handler that was resolved
+ * when the instruction was decoded, with its already extracted operands.
  *
  * @param self A pointer to the Chip8 object.
  */
 void chip8_inst_emulate(Chip8 *self) {
-  chip8_instructions[GET_NIBBLE(self->op_code, 3)](self);
+  self->inst->handler(self, self->inst);
+}
+
+/**
+ * @brief Executes a single opcode, that was already fetched.
+ *
+ * The PC must already point past the opcode. This is the entry point of the
+ * recompiled ROMs into the interpreter, for the instructions they don't
+ * recompile themselves.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param op_code The 16-bits opcode to be executed.
+ */
+void chip8_execute_opcode(Chip8 *self, uint16_t op_code) {
+  Chip8Inst inst;
+
+  chip8_decode_profile(self, op_code, &inst);
+  inst.handler(self, &inst);
 }
 
+/**
+ * @brief Executes instructions by calling the handler of each predecoded
+ * instruction through the array of function pointers.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute_table(Chip8 *self, uint32_t count) {
+  self->stop = CHIP8_STOP_BUDGET;
 
-void chip8_keyboard_control(Chip8 *self) {
-  for (int i = 0; i < 16; i++) {
-    printf("The state of the keyboard is %d.\n", self->keypad[i]);
-  }
+  for (uint32_t i = 0; i < count; i++) {
+    const Chip8Inst *inst = chip8_fetch(self);
+    inst->handler(self, inst);
+    self->cycles++;
 
-  if (IsKeyDown(KEY_X)) {
-    self->keypad[0] = 1;
-  } else {
-    self->keypad[0] = 0;
+    if (self->stop != CHIP8_STOP_BUDGET) {
+      return i + 1;
+    }
   }
 
-  if (IsKeyDown(KEY_ONE)) {
-    self->keypad[1] = 1;
-  } else {
-    self->keypad[1] = 0;
-  }
+  return count;
+}
 
-  if (IsKeyDown(KEY_TWO)) {
-    self->keypad[2] = 1;
-  } else {
-    self->keypad[2] = 0;
-  }
+/**
+ * @brief Executes instructions using a threaded interpreter.
+ *
+ * Every instruction has its own label that calls its handler directly, and
+ * then jumps straight to the label of the next instruction. This replaces the
+ * single shared indirect call with one dispatch site per instruction, which is
+ * much easier for the branch predictor. It relies on the labels-as-values GCC
+ * extension, and falls back to chip8_execute_table() without it.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute_threaded(Chip8 *self, uint32_t count) {
+#if defined(__GNUC__)
+  static void *const labels[CHIP8_OP_COUNT] = {
+      [CHIP8_OP_IGNORE] = &&op_ignore,
+      [CHIP8_OP_TRAP] = &&op_trap,
+      [CHIP8_OP_00CN] = &&op_handler,
+      [CHIP8_OP_00E0] = &&op_00e0,
+      [CHIP8_OP_00EE] = &&op_00ee,
+      [CHIP8_OP_00FB] = &&op_handler,
+      [CHIP8_OP_00FC] = &&op_handler,
+      [CHIP8_OP_00FD] = &&op_handler,
+      [CHIP8_OP_00FE] = &&op_handler,
+      [CHIP8_OP_00FF] = &&op_handler,
+      [CHIP8_OP_1NNN] = &&op_1nnn,
+      [CHIP8_OP_2NNN] = &&op_2nnn,
+      [CHIP8_OP_3XKK] = &&op_3xkk,
+      [CHIP8_OP_4XKK] = &&op_4xkk,
+      [CHIP8_OP_5XY0] = &&op_5xy0,
+      [CHIP8_OP_5XY2] = &&op_handler,
+      [CHIP8_OP_5XY3] = &&op_handler,
+      [CHIP8_OP_6XKK] = &&op_6xkk,
+      [CHIP8_OP_7XKK] = &&op_7xkk,
+      [CHIP8_OP_8XY0] = &&op_8xy0,
+      [CHIP8_OP_8XY1] = &&op_8xy1,
+      [CHIP8_OP_8XY2] = &&op_8xy2,
+      [CHIP8_OP_8XY3] = &&op_8xy3,
+      [CHIP8_OP_8XY4] = &&op_8xy4,
+      [CHIP8_OP_8XY5] = &&op_8xy5,
+      [CHIP8_OP_8XY6] = &&op_8xy6,
+      [CHIP8_OP_8XY7] = &&op_8xy7,
+      [CHIP8_OP_8XYE] = &&op_8xye,
+      [CHIP8_OP_9XY0] = &&op_9xy0,
+      [CHIP8_OP_ANNN] = &&op_annn,
+      [CHIP8_OP_BNNN] = &&op_bnnn,
+      [CHIP8_OP_CXKK] = &&op_cxkk,
+      [CHIP8_OP_DXYN] = &&op_dxyn,
+      [CHIP8_OP_EX9E] = &&op_ex9e,
+      [CHIP8_OP_EXA1] = &&op_exa1,
+      [CHIP8_OP_F000] = &&op_handler,
+      [CHIP8_OP_FN01] = &&op_handler,
+      [CHIP8_OP_F002] = &&op_handler,
+      [CHIP8_OP_FX07] = &&op_fx07,
+      [CHIP8_OP_FX0A] = &&op_fx0a,
+      [CHIP8_OP_FX15] = &&op_fx15,
+      [CHIP8_OP_FX18] = &&op_fx18,
+      [CHIP8_OP_FX1E] = &&op_fx1e,
+      [CHIP8_OP_FX29] = &&op_fx29,
+      [CHIP8_OP_FX30] = &&op_handler,
+      [CHIP8_OP_FX33] = &&op_fx33,
+      [CHIP8_OP_FX3A] = &&op_handler,
+      [CHIP8_OP_FX55] = &&op_fx55,
+      [CHIP8_OP_FX65] = &&op_fx65,
+      [CHIP8_OP_FX75] = &&op_handler,
+      [CHIP8_OP_FX85] = &&op_handler,
+  };
+  const Chip8Inst *inst;
+  uint32_t remaining = count;
+  uint64_t end = self->cycles + count;
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  /* The cycles are brought up to date before every instruction. */
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    self->cycles = end - remaining;                                            \
+    if (remaining == 0 || self->stop != CHIP8_STOP_BUDGET) {                   \
+      return count - remaining;                                                \
+    }                                                                          \
+    remaining--;                                                               \
+    inst = chip8_fetch(self);                                                  \
+    goto *labels[inst->kind];                                                  \
+  } while (0)
+
+  DISPATCH();
+
+op_ignore:
+  DISPATCH();
+op_trap:
+  Chip8_OP_trap(self, inst);
+  DISPATCH();
+op_00e0:
+  Chip8_OP_00e0(self, inst);
+  DISPATCH();
+op_00ee:
+  Chip8_OP_00ee(self, inst);
+  DISPATCH();
+op_1nnn:
+  Chip8_OP_1nnn(self, inst);
+  DISPATCH();
+op_2nnn:
+  Chip8_OP_2nnn(self, inst);
+  DISPATCH();
+op_3xkk:
+  Chip8_OP_3xkk(self, inst);
+  DISPATCH();
+op_4xkk:
+  Chip8_OP_4xkk(self, inst);
+  DISPATCH();
+op_5xy0:
+  Chip8_OP_5xy0(self, inst);
+  DISPATCH();
+op_6xkk:
+  Chip8_OP_6xkk(self, inst);
+  DISPATCH();
+op_7xkk:
+  Chip8_OP_7xkk(self, inst);
+  DISPATCH();
+op_8xy0:
+  Chip8_OP_8xy0(self, inst);
+  DISPATCH();
+op_8xy1:
+  inst->handler(self, inst);
+  DISPATCH();
+op_8xy2:
+  inst->handler(self, inst);
+  DISPATCH();
+op_8xy3:
+  inst->handler(self, inst);
+  DISPATCH();
+op_8xy4:
+  Chip8_OP_8xy4(self, inst);
+  DISPATCH();
+op_8xy5:
+  Chip8_OP_8xy5(self, inst);
+  DISPATCH();
+op_8xy6:
+  inst->handler(self, inst);
+  DISPATCH();
+op_8xy7:
+  Chip8_OP_8xy7(self, inst);
+  DISPATCH();
+op_8xye:
+  inst->handler(self, inst);
+  DISPATCH();
+op_9xy0:
+  Chip8_OP_9xy0(self, inst);
+  DISPATCH();
+op_annn:
+  Chip8_OP_annn(self, inst);
+  DISPATCH();
+op_bnnn:
+  inst->handler(self, inst);
+  DISPATCH();
+op_cxkk:
+  Chip8_OP_cxkk(self, inst);
+  DISPATCH();
+op_dxyn:
+  inst->handler(self, inst);
+  DISPATCH();
+op_ex9e:
+  Chip8_OP_ex9e(self, inst);
+  DISPATCH();
+op_exa1:
+  Chip8_OP_exa1(self, inst);
+  DISPATCH();
+op_fx07:
+  Chip8_OP_fx07(self, inst);
+  DISPATCH();
+op_fx0a:
+  Chip8_OP_fx0a(self, inst);
+  DISPATCH();
+op_fx15:
+  Chip8_OP_fx15(self, inst);
+  DISPATCH();
+op_fx18:
+  Chip8_OP_fx18(self, inst);
+  DISPATCH();
+op_fx1e:
+  Chip8_OP_fx1e(self, inst);
+  DISPATCH();
+op_fx29:
+  Chip8_OP_fx29(self, inst);
+  DISPATCH();
+op_fx33:
+  Chip8_OP_fx33(self, inst);
+  DISPATCH();
+op_fx55:
+  inst->handler(self, inst);
+  DISPATCH();
+op_fx65:
+  inst->handler(self, inst);
+  DISPATCH();
+  /* The SUPER-CHIP and XO-CHIP instructions, which differ between the
+   * profiles. */
+op_handler:
+  inst->handler(self, inst);
+  DISPATCH();
+
+#undef DISPATCH
+#else
+  return chip8_execute_table(self, count);
+#endif
+}
 
-  if (IsKeyDown(KEY_THREE)) {
-    self->keypad[3] = 1;
-  } else {
-    self->keypad[3] = 0;
+/**
+ * @brief Sets the CPU rate that the timers are ticked from.
+ *
+ * The timers tick 60 times per second of emulated time, that is once every
+ * rate / 60 cycles, whatever the speed of the host. The ticks already run and
+ * the fraction of the current one are kept across the change.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param rate The instructions per second.
+ */
+void chip8_set_rate(Chip8 *self, uint32_t rate) {
+  if (rate == 0) {
+    rate = 1;
+  }
+  if (rate == self->timer_rate) {
+    return;
   }
 
-  if (IsKeyDown(KEY_Q)) {
-    self->keypad[4] = 1;
-  } else {
-    self->keypad[4] = 0;
+  uint64_t elapsed = (self->cycles - self->timer_cycle) *
+                         CHIP8_CLOCK_FRAME_RATE +
+                     self->timer_phase;
+
+  self->timer_ticks += elapsed / self->timer_rate;
+  self->timer_phase = elapsed % self->timer_rate * rate / self->timer_rate;
+  self->timer_cycle = self->cycles;
+  self->timer_rate = rate;
+}
+
+/**
+ * @brief Returns the number of timer ticks since the start, at the current
+ * cycle.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+uint64_t chip8_timer_ticks(const Chip8 *self) {
+  return self->timer_ticks + ((self->cycles - self->timer_cycle) *
+                                  CHIP8_CLOCK_FRAME_RATE +
+                              self->timer_phase) /
+                                 self->timer_rate;
+}
+
+/**
+ * @brief Returns the first cycle at which a number of ticks is reached.
+ */
+static uint64_t chip8_timer_cycle(const Chip8 *self, uint64_t ticks) {
+  uint64_t phase = (ticks - self->timer_ticks) * self->timer_rate -
+                   self->timer_phase;
+
+  return self->timer_cycle +
+         (phase + CHIP8_CLOCK_FRAME_RATE - 1) / CHIP8_CLOCK_FRAME_RATE;
+}
+
+/**
+ * @brief Returns the delay timer at the current cycle.
+ *
+ * The timers aren't counted down on every tick: Fx15 and Fx18 keep the value
+ * and the tick they were set at, and the current value is worked out from
+ * them when it's read.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+uint8_t chip8_delay_timer(const Chip8 *self) {
+  uint64_t elapsed = chip8_timer_ticks(self) - self->delay_tick;
+
+  return elapsed < self->delay_timer ? self->delay_timer - elapsed : 0;
+}
+
+/**
+ * @brief Returns the sound timer at the current cycle, the sound plays while
+ * it isn't 0.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+uint8_t chip8_sound_timer(const Chip8 *self) {
+  uint64_t elapsed = chip8_timer_ticks(self) - self->sound_tick;
+
+  return elapsed < self->sound_timer ? self->sound_timer - elapsed : 0;
+}
+
+/**
+ * @brief Returns the cycle at which the idle loop the PC was just sent back
+ * to can exit, or UINT64_MAX if it never does.
+ *
+ * A jump to self never exits. A loop that polls the delay timer with Fx07 and
+ * 3xkk exits when the timer reaches kk, and one that polls it with 4xkk exits
+ * when the timer leaves kk, which are both known in advance.
+ */
+static uint64_t chip8_idle_wake(const Chip8 *self) {
+  uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+  uint16_t poll = self->memory[pc] << 8 |
+                  self->memory[(pc + 1) & (CHIP8_MEMORY_SIZE - 1)];
+  uint16_t skip = self->memory[(pc + 2) & (CHIP8_MEMORY_SIZE - 1)] << 8 |
+                  self->memory[(pc + 3) & (CHIP8_MEMORY_SIZE - 1)];
+
+  if ((poll & 0xF0FF) != 0xF007) {
+    return UINT64_MAX;
   }
 
-  if (IsKeyDown(KEY_W)) {
-    self->keypad[5] = 1;
+  uint8_t delay = chip8_delay_timer(self);
+  uint8_t kk = skip & 0xFF;
+  uint8_t ticks;
+
+  if ((skip & 0xF000) == 0x3000) {
+    /* Waits for the timer to count down to kk. */
+    if (delay < kk) {
+      return UINT64_MAX;
+    }
+    ticks = delay - kk;
   } else {
-    self->keypad[5] = 0;
+    /* Waits for the timer to count down from kk. */
+    if (delay != kk) {
+      return self->cycles;
+    }
+    if (kk == 0) {
+      return UINT64_MAX;
+    }
+    ticks = 1;
   }
 
-  if (IsKeyDown(KEY_E)) {
-    self->keypad[6] = 1;
-  } else {
-    self->keypad[6] = 0;
+  if (ticks == 0) {
+    return self->cycles;
   }
 
-  if (IsKeyDown(KEY_A)) {
-    self->keypad[7] = 1;
-  } else {
-    self->keypad[7] = 0;
+  return chip8_timer_cycle(self, chip8_timer_ticks(self) + ticks);
+}
+
+/**
+ * @brief Skips the iterations of the idle loop the PC was just sent back to
+ * that can't exit before its wake cycle or the end of the budget.
+ *
+ * Only whole iterations are skipped, so the loop is left at the same
+ * instruction, with the same cycles, as if it had been run: up to the first
+ * poll that sees the timer it waits for, or up to the last iteration that fits
+ * in the budget, whose instructions are then run. The Vx of a polling loop is
+ * set to what its last skipped Fx07 would have read.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param end The cycle at which the budget ends.
+ */
+static void chip8_idle_skip(Chip8 *self, uint64_t end) {
+  uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+  uint16_t poll = self->memory[pc] << 8 |
+                  self->memory[(pc + 1) & (CHIP8_MEMORY_SIZE - 1)];
+  /* Fx07, 3xkk or 4xkk and the jump, or the jump alone. */
+  uint64_t length = (poll & 0xF0FF) == 0xF007 ? 3 : 1;
+  uint64_t wake = chip8_idle_wake(self);
+  uint64_t start = self->cycles;
+  uint64_t until = start + (end - start) / length * length;
+
+  if (wake <= start) {
+    return;
+  }
+  if (wake < end) {
+    uint64_t woken = start + (wake - start + length - 1) / length * length;
+    until = woken < until ? woken : until;
+  }
+  if (until == start) {
+    return;
   }
 
-  if (IsKeyDown(KEY_S)) {
-    self->keypad[8] = 1;
-  } else {
-    self->keypad[8] = 0;
+  if (length == 3) {
+    self->cycles = until - length;
+    self->registers[(poll >> 8) & 0xF] = chip8_delay_timer(self);
   }
 
-  if (IsKeyDown(KEY_D)) {
-    self->keypad[9] = 1;
-  } else {
-    self->keypad[9] = 0;
+  self->idle_cycles += until - start;
+  self->idle_skips++;
+  self->cycles = until;
+}
+
+/**
+ * @brief Executes up to n instructions, and tells why it stopped.
+ *
+ * The instructions are run by chip8_execute(), so by the engine selected at
+ * build time or the recompiled ROM, until the budget is spent or an
+ * instruction asks to stop: Fx0A waiting for a key, 00E0 or Dxyn changing the
+ * display, or an invalid opcode. While breakpoints are set, the instructions
+ * are run one at a time from the predecoded instructions instead, and it also
+ * stops before the instruction at a breakpoint, except right after stopping at
+ * that breakpoint, so that calling it again resumes from there.
+ *
+ * The timers count from the cycles of the Chip8 object, which are kept up to
+ * date after every instruction, so a run only depends on the ROM, the rate and
+ * the keys, and not on how fast the host is or how the budget is split.
+ *
+ * Idle loops, that jump to themselves or poll the delay timer, can't change
+ * anything until the delay timer reaches the value they wait for, so their
+ * iterations up to then are skipped at once when one is hit, and the execution
+ * goes on from there in the same state as without the skip. Fx0A waiting for
+ * a key can't change anything until a key press, which happens outside of
+ * this function, so the rest of the budget is skipped. The skipped cycles are
+ * counted in the idle stats of the Chip8 object. This is disabled while
+ * breakpoints are set.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param n The maximum number of instructions to be executed.
+ * @return The reason the execution stopped, CHIP8_STOP_IDLE if the budget
+ * ended in an idle loop.
+ */
+Chip8Stop chip8_run_cycles(Chip8 *self, uint32_t n) {
+  uint64_t start = self->cycles;
+  uint64_t end = start + n;
+  uint8_t resuming = self->stop == CHIP8_STOP_BREAKPOINT;
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  while (self->cycles < end) {
+    if (self->breakpoint_count == 0) {
+      chip8_execute(self, end - self->cycles);
+    } else {
+      if (!(resuming && self->cycles == start) &&
+          self->breakpoints[self->pc & (CHIP8_MEMORY_SIZE - 1)]) {
+        self->stop = CHIP8_STOP_BREAKPOINT;
+        break;
+      }
+
+      const Chip8Inst *inst = chip8_fetch(self);
+      inst->handler(self, inst);
+      self->cycles++;
+    }
+
+    if (self->stop == CHIP8_STOP_BUDGET) {
+      continue;
+    }
+
+    if (self->breakpoint_count == 0 && self->stop == CHIP8_STOP_WAIT_KEY) {
+      self->idle_cycles += end - self->cycles;
+      self->idle_skips++;
+      self->cycles = end;
+    }
+
+    if (self->breakpoint_count == 0 && self->stop == CHIP8_STOP_IDLE) {
+      chip8_idle_skip(self, end);
+
+      if (self->cycles < end) {
+        self->stop = CHIP8_STOP_BUDGET;
+        continue;
+      }
+    }
+
+    break;
   }
 
-  if (IsKeyDown(KEY_Z)) {
-    self->keypad[10] = 1;
-  } else {
-    self->keypad[10] = 0;
+  return self->stop;
+}
+
+/**
+ * @brief Sets or clears a breakpoint for chip8_run_cycles().
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param addr The address of the instruction to stop at.
+ * @param enabled Non-zero to set the breakpoint, zero to clear it.
+ */
+void chip8_set_breakpoint(Chip8 *self, uint16_t addr, uint8_t enabled) {
+  uint8_t *breakpoint = &self->breakpoints[addr & (CHIP8_MEMORY_SIZE - 1)];
+
+  enabled = enabled != 0;
+  if (*breakpoint != enabled) {
+    self->breakpoint_count += enabled ? 1 : -1;
+    *breakpoint = enabled;
   }
+}
 
-  if (IsKeyDown(KEY_C)) {
-    self->keypad[11] = 1;
-  } else {
-    self->keypad[11] = 0;
+/**
+ * @brief Executes instructions without the predecoded instruction cache.
+ *
+ * Every opcode is fetched from memory and resolved on the spot through the
+ * single-level dispatch table, which is how every instruction was executed
+ * before the instructions were predecoded.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute_direct(Chip8 *self, uint32_t count) {
+  Chip8Inst inst;
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+    uint16_t op_code = self->memory[pc] << 8;
+    op_code |= self->memory[(pc + 1) & (CHIP8_MEMORY_SIZE - 1)];
+    self->pc = pc + 2;
+
+    chip8_decode_profile(self, op_code, &inst);
+    chip8_trace_record(self, pc, &inst);
+    inst.handler(self, &inst);
+    self->cycles++;
+
+    if (self->stop != CHIP8_STOP_BUDGET) {
+      return i + 1;
+    }
   }
 
-  if (IsKeyDown(KEY_FOUR)) {
-    self->keypad[12] = 1;
-  } else {
-    self->keypad[12] = 0;
+  return count;
+}
+
+/**
+ * @brief Executes instructions using the recompiled ROM if one was loaded, or
+ * the engine selected at build time otherwise.
+ *
+ * Every engine counts the instructions it executes in the cycles of the Chip8
+ * object, before the next one runs, so the timers read the same values
+ * whichever engine runs the ROM. Every engine also returns early once an
+ * instruction raised a stop in the Chip8 object, at the latest at the end of
+ * the native block it was run from.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute(Chip8 *self, uint32_t count) {
+  if (self->aot != NULL) {
+    return chip8_execute_aot(self, count);
   }
 
-  if (IsKeyDown(KEY_R)) {
-    self->keypad[13] = 1;
-  } else {
-    self->keypad[13] = 0;
+#if defined(CHIP8_ENGINE_THREADED)
+  return chip8_execute_threaded(self, count);
+#elif defined(CHIP8_ENGINE_JIT)
+  return chip8_execute_jit(self, count);
+#else
+  return chip8_execute_table(self, count);
+#endif
+}
+
+
+/* The keys of the keyboard for the keys 0 to F of the keypad. */
+static const int chip8_keymap[16] = {
+    KEY_X, KEY_ONE, KEY_TWO, KEY_THREE, KEY_Q, KEY_W, KEY_E, KEY_A,
+    KEY_S, KEY_D, KEY_Z, KEY_C, KEY_FOUR, KEY_R, KEY_F, KEY_V};
+
+/**
+ * @brief Returns the keys of the keypad held on the keyboard, key k in bit k.
+ *
+ * It only reads the state raylib polled, so it belongs to the thread of the
+ * window, and the mask can be handed to another thread running the core.
+ */
+uint16_t chip8_keyboard_read(void) {
+  uint16_t keys = 0;
+
+  for (int i = 0; i < 16; i++) {
+    if (IsKeyDown(chip8_keymap[i])) {
+      keys |= 1 << i;
+    }
   }
 
-  if (IsKeyDown(KEY_F)) {
-    self->keypad[14] = 1;
-  } else {
-    self->keypad[14] = 0;
+  return keys;
+}
+
+/**
+ * @brief Sets the keys of the keypad that are held.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param keys The keys held, key k in bit k.
+ */
+void chip8_set_keys(Chip8 *self, uint16_t keys) {
+  for (int i = 0; i < 16; i++) {
+    self->keypad[i] = (keys >> i) & 1;
   }
 
-  if (IsKeyDown(KEY_V)) {
-    self->keypad[15] = 1;
-  } else {
-    self->keypad[15] = 0;
+  if (CHIP8_LOG_ENABLED(CHIP8_LOG_LEVEL_TRACE)) {
+    for (int i = 0; i < 16; i++) {
+      CHIP8_LOG_TRACE("The state of the keyboard is %d.\n", self->keypad[i]);
+    }
   }
 }
 
-void chip8_draw(Chip8 *self, Rectangle *pixel) {
-  for (int i = 0; i < CHIP8_SCREEN_HEIGHT; i++) {
-    for (int j = 0; j < CHIP8_SCREEN_WIDTH; j++) {
-      if (self->graphics[j][i] == 1) {
-      pixel->x = j * 10;
-      pixel->y = i * 10;
-      DrawRectangleRounded(*pixel, 0.1, 6, BLACK);
+/**
+ * @brief Sets the keys of the keypad from the keyboard.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_keyboard_control(Chip8 *self) {
+  chip8_set_keys(self, chip8_keyboard_read());
+}
+
+/**
+ * @brief Mixes the bits of a hash, with the finalizer of MurmurHash3.
+ */
+static inline uint64_t chip8_hash_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * @brief Returns a 64-bit hash of the screen.
+ *
+ * Every row has its own hash, of its words in every plane and of its index,
+ * and the hash of the screen is the sum of the hashes of the rows. Only the
+ * rows marked as dirty are hashed again, and their old hash is swapped for the
+ * new one in the sum, so hashing a frame where a single sprite moved costs a
+ * few rows, not the whole screen. The mode is hashed too, so that a blank low
+ * resolution screen and a blank high resolution one differ.
+ *
+ * The dirty rows are left for chip8_take_dirty_rows(). Two runs of a ROM can
+ * be compared frame by frame with their hashes alone.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @return The hash of the screen.
+ */
+uint64_t chip8_frame_hash(Chip8 *self) {
+  uint64_t rows = self->dirty_rows;
+
+  while (rows != 0) {
+    int y = __builtin_ctzll(rows);
+    uint64_t hash = (y + 1) * 0x9e3779b97f4a7c15ULL;
+
+    for (int p = 0; p < CHIP8_PLANES; p++) {
+      for (int w = 0; w < CHIP8_SCREEN_WORDS; w++) {
+        hash = chip8_hash_mix(hash ^ self->graphics[p][w][y]);
       }
     }
+
+    self->screen_hash += hash - self->row_hashes[y];
+    self->row_hashes[y] = hash;
+    rows &= rows - 1;
   }
+
+  return chip8_hash_mix(self->screen_hash + self->hires);
 }
 
-double current_time;
-double last_update_time;
+/**
+ * @brief Returns the rows of the screen changed since the last call, and
+ * marks them as presented.
+ *
+ * 00E0 marks the rows it blanks, and Dxyn the rows it draws on. Frontends and
+ * encoders can redraw or re-encode only these rows, and skip idle frames.
+ * Rows are often changed and changed back before the next present, like a
+ * sprite erased and drawn again at the same place, so no row is returned when
+ * the frame hash is the same as at the last call.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @return A bit mask with bit i set if row i changed.
+ */
+uint64_t chip8_take_dirty_rows(Chip8 *self) {
+  uint64_t dirty = self->dirty_rows;
+
+  if (dirty != 0) {
+    uint64_t hash = chip8_frame_hash(self);
 
-void chip8_timer_control(Chip8 *self) {
-  current_time = GetTime();
-  printf("The current time: %lf\n", current_time);
-  if (current_time - last_update_time >= SPECIFIED_TIME) {
-    if (self->delay_timer > 0) {
-      self->delay_timer--;
+    if (hash == self->presented_hash) {
+      dirty = 0;
     }
-    last_update_time = current_time;
+    self->presented_hash = hash;
   }
+
+  self->dirty_rows = 0;
+  return dirty;
+}
+
+/**
+ * @brief Draws the screen.
+ *
+ * The dirty rows are converted to RGBA pixels on the CPU, and the band of the
+ * texture between the first and the last of them is updated with a single
+ * upload. The whole screen is then drawn as one textured quad.
+ *
+ * @param screen The screen, whose dirty rows are set by chip8_frames_show().
+ * @param render The RGBA pixels of the screen.
+ * @param texture A texture the size of the RGBA pixels.
+ */
+void chip8_draw(Chip8Screen *screen, Chip8Render *render, Texture2D *texture) {
+  uint64_t dirty = screen->dirty_rows;
+
+  screen->dirty_rows = 0;
+
+  if (dirty != 0) {
+    chip8_render_rows(render, screen, dirty);
+
+    /* The rows past the bottom of the screen can be marked by a scroll. */
+    dirty &= screen->hires ? CHIP8_ALL_ROWS
+                           : (1ULL << CHIP8_SCREEN_HEIGHT) - 1;
+  }
+
+  if (dirty != 0) {
+    uint8_t cell = chip8_render_cell(render, screen);
+    int top = __builtin_ctzll(dirty) * cell;
+    int bottom = (64 - __builtin_clzll(dirty)) * cell;
+    UpdateTextureRec(*texture,
+                     (Rectangle){0, top, render->width, bottom - top},
+                     &render->pixels[top * render->width]);
+  }
+
+  DrawTexture(*texture, 0, 0, WHITE);
 }
@@ -0,0 +1,183 @@
+#include "chip8_aot.h"
+#include "chip8.h"
+#include "chip8_log.h"
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Computes a FNV-1a hash of a ROM.
+ *
+ * The hash is written into the recompiled shared object by tools/chip8_aot,
+ * and compared to the hash of the loaded program before it's used.
+ *
+ * @param rom The bytes of the ROM.
+ * @param size The size of the ROM.
+ */
+uint32_t chip8_aot_hash(const uint8_t *rom, uint32_t size) {
+  uint32_t hash = 2166136261u;
+
+  for (uint32_t i = 0; i < size; i++) {
+    hash = (hash ^ rom[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Loads the shared object recompiled from the loaded ROM.
+ *
+ * Must be called after chip8_load_rom(). The shared object is rejected if it
+ * was recompiled from a different ROM, or by another version of
+ * tools/chip8_aot.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param path The path of the shared object.
+ * @return 0 on success, 1 otherwise.
+ */
+int chip8_aot_load(Chip8 *self, const char *path) {
+  chip8_aot_free(self);
+
+  void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL) {
+    CHIP8_LOG_ERROR("Can't load the recompiled ROM %s: %s\n", path, dlerror());
+    return 1;
+  }
+
+  const Chip8AotBlock *blocks = dlsym(handle, "chip8_aot_blocks");
+  const uint32_t *block_count = dlsym(handle, "chip8_aot_block_count");
+  const uint32_t *rom_size = dlsym(handle, "chip8_aot_rom_size");
+  const uint32_t *rom_hash = dlsym(handle, "chip8_aot_rom_hash");
+  const uint32_t *version = dlsym(handle, "chip8_aot_version");
+
+  if (blocks == NULL || block_count == NULL || rom_size == NULL ||
+      rom_hash == NULL) {
+    CHIP8_LOG_ERROR("%s isn't a recompiled ROM.\n", path);
+    dlclose(handle);
+    return 1;
+  }
+
+  if (version == NULL || *version != CHIP8_AOT_VERSION) {
+    CHIP8_LOG_ERROR("%s was recompiled by another version of "
+                    "tools/chip8_aot.\n",
+                    path);
+    dlclose(handle);
+    return 1;
+  }
+
+  if (*rom_size > CHIP8_MEMORY_SIZE - ENTRY_POINT ||
+      chip8_aot_hash(&self->memory[ENTRY_POINT], *rom_size) != *rom_hash) {
+    CHIP8_LOG_ERROR("%s was recompiled from a different ROM.\n", path);
+    dlclose(handle);
+    return 1;
+  }
+
+  self->aot = calloc(1, sizeof(*self->aot));
+  if (self->aot == NULL) {
+    dlclose(handle);
+    return 1;
+  }
+
+  self->aot->handle = handle;
+  for (uint32_t i = 0; i < *block_count; i++) {
+    const Chip8AotBlock *block = &blocks[i];
+    self->aot->blocks[block->start >> 1] = block;
+    for (uint16_t addr = block->start; addr < block->end; addr += 2) {
+      self->aot->cover[addr >> 1]++;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Drops the recompiled blocks that contain a written address.
+ *
+ * The instructions of a dropped block are interpreted from then on, as the
+ * recompiled code no longer matches them.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param addr The written address.
+ */
+void chip8_aot_invalidate(Chip8 *self, uint16_t addr) {
+  Chip8Aot *aot = self->aot;
+  uint16_t index = (addr & (CHIP8_MEMORY_SIZE - 1)) >> 1;
+
+  if (aot->cover[index] == 0) {
+    return;
+  }
+
+  /* A block that covers the index can't start further back than this, with
+   * the instruction skipped at its end. */
+  uint16_t first =
+      index >= CHIP8_AOT_MAX_LENGTH ? index - CHIP8_AOT_MAX_LENGTH : 0;
+
+  for (uint16_t start = first; start <= index; start++) {
+    const Chip8AotBlock *block = aot->blocks[start];
+    if (block != NULL && block->end > (index << 1)) {
+      for (uint16_t a = block->start; a < block->end; a += 2) {
+        aot->cover[a >> 1]--;
+      }
+      aot->blocks[start] = NULL;
+    }
+  }
+}
+
+/**
+ * @brief Unloads the recompiled ROM.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_aot_free(Chip8 *self) {
+  if (self->aot == NULL) {
+    return;
+  }
+
+  dlclose(self->aot->handle);
+  free(self->aot);
+  self->aot = NULL;
+}
+
+/**
+ * @brief Executes instructions using the recompiled ROM.
+ *
+ * Every recompiled block is run as a native function. The addresses that have
+ * no block, such as the targets of Bnnn jumps, the blocks dropped by
+ * self-modifying code, and the blocks longer than the remaining count, are
+ * executed by chip8_inst_emulate().
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute_aot(Chip8 *self, uint32_t count) {
+  uint32_t executed = 0;
+
+  if (self->aot == NULL) {
+    return chip8_execute(self, count);
+  }
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  while (executed < count && self->stop == CHIP8_STOP_BUDGET) {
+    uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+
+    if ((pc & 1) == 0) {
+      const Chip8AotBlock *block = self->aot->blocks[pc >> 1];
+
+      if (block != NULL && block->length <= count - executed) {
+        self->pc = pc;
+        executed += block->run(self);
+        continue;
+      }
+    }
+
+    chip8_parse_code(self);
+    chip8_inst_emulate(self);
+    self->cycles++;
+    executed++;
+  }
+
+  return executed;
+}
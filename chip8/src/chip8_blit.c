@@ -0,0 +1,166 @@
+/**
+ * @file chip8_blit.c
+ * @brief The sprite drawing of Dxyn.
+ *
+ * Every row of the screen is one 64-bit word for every 64 columns, with the
+ * leftmost pixel in the most significant bit. A sprite row is lined up with the
+ * leftmost pixel, shifted to its column, ANDed with the words of the screen it
+ * lands on to find the collisions, and XORed into them. A sprite that crosses
+ * the boundary of two words is drawn into each of them with its own shifts, and
+ * a sprite that wraps around a 64 pixels wide screen is rotated.
+ *
+ * The rows are drawn one at a time with plain integer operations.
+ */
+#include "chip8_blit.h"
+#include "chip8.h"
+#include <stdint.h>
+
+_Static_assert(CHIP8_SCREEN_WIDTH == 64,
+               "A low resolution row is a single uint64_t.");
+
+/**
+ * @brief Lines a sprite row up with the leftmost pixel of a screen row.
+ */
+static inline uint64_t chip8_blit_row(const uint8_t *sprite, uint8_t row,
+                                      uint8_t wide) {
+  if (wide) {
+    return ((uint64_t)sprite[2 * row] << 56) |
+           ((uint64_t)sprite[2 * row + 1] << 48);
+  }
+
+  return (uint64_t)sprite[row] << 56;
+}
+
+/**
+ * @brief Draws consecutive sprite rows over consecutive words of the screen.
+ *
+ * Every sprite row is lined up with the most significant bit, and the word
+ * drawn is the row shifted right by `right` ORed with the row shifted left by
+ * `left`. A shift by 64 gives 0, so that the same code draws the part of a
+ * sprite that lands in its word, the part that spills over from the word on
+ * its left, or both when the sprite wraps around a 64 pixels wide screen.
+ *
+ * @param rows The first word of the screen to draw on.
+ * @param sprite The first row of the sprite, 1 byte per row or 2 if wide.
+ * @param count The number of rows.
+ * @param wide Set for 16 pixels wide sprites.
+ * @param right The right shift, from 0 to 64.
+ * @param left The left shift, from 1 to 64.
+ * @return 1 if any pixel was erased, 0 otherwise.
+ */
+static uint8_t chip8_blit_words(uint64_t *rows, const uint8_t *sprite,
+                                uint8_t count, uint8_t wide, uint8_t right,
+                                uint8_t left) {
+  uint64_t collision = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    uint64_t row = chip8_blit_row(sprite, i, wide);
+    uint64_t bits = (right < 64 ? row >> right : 0) |
+                    (left < 64 ? row << left : 0);
+
+    collision |= rows[i] & bits;
+    rows[i] ^= bits;
+  }
+
+  return collision != 0;
+}
+
+/**
+ * @brief Draws sprite rows that don't cross the bottom of the screen into the
+ * words they land on.
+ */
+static uint8_t chip8_blit_span(uint64_t screen[][CHIP8_HIRES_HEIGHT],
+                               uint8_t width, const uint8_t *sprite, uint8_t x,
+                               uint8_t y, uint8_t count, uint8_t wide,
+                               uint8_t clip) {
+  uint8_t word = x / 64;
+  uint8_t shift = x % 64;
+  uint8_t next = (word + 1) % (width / 64);
+
+  /* The sprite fits in its word, or is clipped at the right edge. */
+  if (shift <= 64 - (8 << wide) || (clip && next == 0)) {
+    return chip8_blit_words(&screen[word][y], sprite, count, wide, shift, 64);
+  }
+
+  /* The sprite wraps around a single word, and is rotated. */
+  if (next == word) {
+    return chip8_blit_words(&screen[word][y], sprite, count, wide, shift,
+                            64 - shift);
+  }
+
+  uint8_t erased =
+      chip8_blit_words(&screen[word][y], sprite, count, wide, shift, 64);
+  erased |= chip8_blit_words(&screen[next][y], sprite, count, wide, 64,
+                             64 - shift);
+
+  return erased;
+}
+
+/**
+ * @brief Draws a sprite on the screen.
+ *
+ * The rows past the bottom of the screen are dropped when the sprites are
+ * clipped, and drawn from the top of the screen otherwise, and the same goes
+ * for the pixels past the right edge.
+ *
+ * @param screen The words of the screen, CHIP8_HIRES_HEIGHT rows for every 64
+ * columns.
+ * @param width The width of the screen, 64 or 128.
+ * @param height The height of the screen, up to 64.
+ * @param sprite The rows of the sprite, 1 byte per row or 2 if wide.
+ * @param x The column of the sprite, taken modulo the width of the screen.
+ * @param y The row of the sprite, taken modulo the height of the screen.
+ * @param rows The number of rows of the sprite, up to 16.
+ * @param wide Set for 16 pixels wide sprites.
+ * @param clip Set to clip the sprite at the edges of the screen, instead of
+ * wrapping it around.
+ * @return 1 if any pixel was erased, 0 otherwise.
+ */
+uint8_t chip8_blit(uint64_t screen[][CHIP8_HIRES_HEIGHT], uint8_t width,
+                   uint8_t height, const uint8_t *sprite, uint8_t x, uint8_t y,
+                   uint8_t rows, uint8_t wide, uint8_t clip) {
+  x %= width;
+  y %= height;
+
+  uint8_t first = rows;
+  if (first > height - y) {
+    first = height - y;
+  }
+
+  uint8_t erased =
+      chip8_blit_span(screen, width, sprite, x, y, first, wide, clip);
+
+  if (!clip && first < rows) {
+    erased |= chip8_blit_span(screen, width, &sprite[first << wide], x, 0,
+                              rows - first, wide, clip);
+  }
+
+  return erased;
+}
+
+/**
+ * @brief Finds the rows of the screen a sprite is drawn on.
+ *
+ * @param height The height of the screen, up to 64.
+ * @param y The row of the sprite, taken modulo the height of the screen.
+ * @param rows The number of rows of the sprite, up to 16.
+ * @param clip Set if the sprite is clipped at the bottom of the screen,
+ * instead of wrapping around.
+ * @return A bit mask with bit i set if the sprite is drawn on row i.
+ */
+uint64_t chip8_blit_rows(uint8_t height, uint8_t y, uint8_t rows,
+                         uint8_t clip) {
+  y %= height;
+
+  uint64_t span = (1ULL << rows) - 1;
+  uint64_t mask = span << y;
+
+  if (!clip && y + rows > height) {
+    mask |= span >> (height - y);
+  }
+  if (height < 64) {
+    mask &= (1ULL << height) - 1;
+  }
+
+  return mask;
+}
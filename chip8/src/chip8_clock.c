@@ -0,0 +1,90 @@
+#include "chip8_clock.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Sets the CPU rate, before the first frame.
+ *
+ * @param self A pointer to the Chip8Clock object.
+ * @param rate The instructions per second, clamped to the supported range.
+ */
+void chip8_clock_init(Chip8Clock *self, uint32_t rate) {
+  memset(self, 0, sizeof(*self));
+  self->sample_start = -1;
+  chip8_clock_set_rate(self, rate);
+}
+
+/**
+ * @brief Returns a CPU rate clamped to the supported range.
+ *
+ * @param rate The instructions per second.
+ */
+uint32_t chip8_clock_clamp(uint32_t rate) {
+  if (rate < CHIP8_CLOCK_MIN_RATE) {
+    return CHIP8_CLOCK_MIN_RATE;
+  }
+  if (rate > CHIP8_CLOCK_MAX_RATE) {
+    return CHIP8_CLOCK_MAX_RATE;
+  }
+
+  return rate;
+}
+
+/**
+ * @brief Changes the CPU rate, from the next frame on.
+ *
+ * The fraction of an instruction carried over is kept, so changing the rate
+ * doesn't drop or add instructions.
+ *
+ * @param self A pointer to the Chip8Clock object.
+ * @param rate The instructions per second, clamped to the supported range.
+ */
+void chip8_clock_set_rate(Chip8Clock *self, uint32_t rate) {
+  self->rate = chip8_clock_clamp(rate);
+}
+
+/**
+ * @brief Returns the number of instructions to run in the next frame.
+ *
+ * A rate that isn't a multiple of the frame rate leaves a fraction of an
+ * instruction every frame, which is carried over to the next ones, so that
+ * 700 instructions per second run as 11, 12, 12, 11, 12, 12... instructions
+ * per frame, and exactly 700 every second.
+ *
+ * @param self A pointer to the Chip8Clock object.
+ */
+uint32_t chip8_clock_budget(Chip8Clock *self) {
+  uint64_t total = (uint64_t)self->carry + self->rate;
+
+  self->carry = total % CHIP8_CLOCK_FRAME_RATE;
+
+  return total / CHIP8_CLOCK_FRAME_RATE;
+}
+
+/**
+ * @brief Counts the instructions executed in a frame, and measures the
+ * instructions per second actually achieved about once a second.
+ *
+ * @param self A pointer to the Chip8Clock object.
+ * @param executed The instructions executed in the frame, including the ones
+ * skipped in idle loops.
+ * @param now The current time, in seconds.
+ * @return 1 if ips was measured again, 0 otherwise.
+ */
+int chip8_clock_sample(Chip8Clock *self, uint32_t executed, double now) {
+  if (self->sample_start < 0) {
+    self->sample_start = now;
+  }
+
+  self->executed += executed;
+
+  if (now - self->sample_start < 1) {
+    return 0;
+  }
+
+  self->ips = self->executed / (now - self->sample_start);
+  self->executed = 0;
+  self->sample_start = now;
+
+  return 1;
+}
@@ -0,0 +1,101 @@
+#include "chip8_frames.h"
+#include "chip8.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Starts with the frames 0, 1 and 2 at the back, in the middle and at
+ * the front, none of them fresh.
+ *
+ * @param self A pointer to the Chip8Frames object.
+ */
+void chip8_frames_init(Chip8Frames *self) {
+  memset(self, 0, sizeof(*self));
+  self->back = 0;
+  atomic_init(&self->middle, 1);
+  self->front = 2;
+}
+
+/**
+ * @brief Copies the screen to the back frame, and swaps it with the middle
+ * one. Called by the writer only.
+ *
+ * @param self A pointer to the Chip8Frames object.
+ * @param chip8 A pointer to the Chip8 object.
+ * @param time The number of the frame.
+ */
+void chip8_frames_publish(Chip8Frames *self, Chip8 *chip8, uint64_t time) {
+  Chip8Frame *frame = &self->frames[self->back];
+
+  /* Bring the hashes of the dirty rows up to date. */
+  chip8_frame_hash(chip8);
+
+  memcpy(frame->graphics, chip8->graphics, sizeof(frame->graphics));
+  memcpy(frame->row_hashes, chip8->row_hashes, sizeof(frame->row_hashes));
+  frame->time = time;
+  frame->hires = chip8->hires;
+
+  uint8_t middle = atomic_exchange_explicit(
+      &self->middle, self->back | CHIP8_FRAMES_FRESH, memory_order_acq_rel);
+  self->back = middle & ~CHIP8_FRAMES_FRESH;
+}
+
+/**
+ * @brief Swaps the front frame with the middle one if a frame was published
+ * since the last call. Called by the reader only.
+ *
+ * @param self A pointer to the Chip8Frames object.
+ * @return The latest frame, or NULL if there's no new frame.
+ */
+const Chip8Frame *chip8_frames_take(Chip8Frames *self) {
+  if (!(atomic_load_explicit(&self->middle, memory_order_relaxed) &
+        CHIP8_FRAMES_FRESH)) {
+    return NULL;
+  }
+
+  uint8_t middle = atomic_exchange_explicit(&self->middle, self->front,
+                                            memory_order_acq_rel);
+  self->front = middle & ~CHIP8_FRAMES_FRESH;
+
+  return &self->frames[self->front];
+}
+
+/**
+ * @brief Copies a frame to the screen the renderer draws from.
+ *
+ * The rows whose hash differs from the one of the row on the screen are
+ * copied with their hash and marked dirty, so chip8_draw() only uploads
+ * those, even when the frames in between were dropped. The whole screen is
+ * copied when the mode changes.
+ *
+ * @param frame The frame returned by chip8_frames_take().
+ * @param display A pointer to the Chip8Screen object drawn by the renderer.
+ */
+void chip8_frames_show(const Chip8Frame *frame, Chip8Screen *display) {
+  uint64_t changed = 0;
+
+  if (frame->hires != display->hires) {
+    display->hires = frame->hires;
+    changed = CHIP8_ALL_ROWS;
+  }
+
+  for (int y = 0; y < CHIP8_HIRES_HEIGHT; y++) {
+    if (frame->row_hashes[y] != display->row_hashes[y]) {
+      changed |= 1ULL << y;
+    }
+  }
+
+  for (uint64_t rows = changed; rows != 0; rows &= rows - 1) {
+    int y = __builtin_ctzll(rows);
+
+    for (int p = 0; p < CHIP8_PLANES; p++) {
+      for (int w = 0; w < CHIP8_SCREEN_WORDS; w++) {
+        display->graphics[p][w][y] = frame->graphics[p][w][y];
+      }
+    }
+    display->row_hashes[y] = frame->row_hashes[y];
+  }
+
+  display->dirty_rows |= changed;
+}
@@ -0,0 +1,646 @@
+#include "chip8_jit.h"
+#include "chip8.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* The x86-64 registers, numbered as they are encoded. */
+enum {
+  RAX = 0,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15
+};
+
+/* RDI holds the Chip8 object, as the first argument of the translated block,
+ * and R11 is kept as a scratch register. The rest hold the Chip-8 registers. */
+static const uint8_t host_regs[] = {RAX, RCX, RDX, RSI, R8,  R9,  R10,
+                                    RBX, RBP, R12, R13, R14, R15};
+
+#define HOST_REG_COUNT (sizeof(host_regs) / sizeof(host_regs[0]))
+
+/* The Chip-8 registers that can be held in host registers: V0 to VF and I. */
+#define SLOT_I 16
+#define SLOT_COUNT 17
+
+/* The worst case size of the code of a single block. */
+#define MAX_BLOCK_CODE 2048
+
+/* x86-64 condition codes. */
+#define CC_C 0x2
+#define CC_E 0x4
+#define CC_NE 0x5
+#define CC_A 0x7
+
+typedef struct {
+  uint8_t *code;
+  uint32_t pos;
+  int8_t host[SLOT_COUNT]; /* The host register of each slot, or -1. */
+  bool dirty[SLOT_COUNT];  /* Set if the slot was written by the block. */
+  uint8_t used;            /* The number of allocated host registers. */
+} Emitter;
+
+/* A decoded instruction of the block, with the slots it uses. */
+typedef struct {
+  Chip8Inst inst;
+  uint8_t slots[3];
+  uint8_t slot_count;
+} JitInst;
+
+static void emit8(Emitter *e, uint8_t byte) { e->code[e->pos++] = byte; }
+
+static void emit32(Emitter *e, uint32_t value) {
+  memcpy(&e->code[e->pos], &value, sizeof(value));
+  e->pos += sizeof(value);
+}
+
+static uint8_t rex(bool w, uint8_t reg, uint8_t rm) {
+  return 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3);
+}
+
+static uint8_t modrm(uint8_t mod, uint8_t reg, uint8_t rm) {
+  return (mod << 6) | ((reg & 7) << 3) | (rm & 7);
+}
+
+/* movzx reg32, byte/word [rdi + offset] */
+static void emit_load(Emitter *e, uint8_t reg, uint32_t offset, bool word) {
+  if (reg >= 8) {
+    emit8(e, rex(false, reg, RDI));
+  }
+  emit8(e, 0x0F);
+  emit8(e, word ? 0xB7 : 0xB6);
+  emit8(e, modrm(2, reg, RDI));
+  emit32(e, offset);
+}
+
+/* mov byte/word [rdi + offset], reg */
+static void emit_store(Emitter *e, uint8_t reg, uint32_t offset, bool word) {
+  if (word) {
+    emit8(e, 0x66);
+    if (reg >= 8) {
+      emit8(e, rex(false, reg, RDI));
+    }
+    emit8(e, 0x89);
+  } else {
+    /* The REX prefix selects SIL/BPL instead of DH/CH. */
+    emit8(e, rex(false, reg, RDI));
+    emit8(e, 0x88);
+  }
+  emit8(e, modrm(2, reg, RDI));
+  emit32(e, offset);
+}
+
+/* mov reg32, imm32 */
+static void emit_mov_imm(Emitter *e, uint8_t reg, uint32_t imm) {
+  if (reg >= 8) {
+    emit8(e, rex(false, 0, reg));
+  }
+  emit8(e, 0xB8 + (reg & 7));
+  emit32(e, imm);
+}
+
+/* <op> dst8, src8 */
+static void emit_alu8(Emitter *e, uint8_t op, uint8_t dst, uint8_t src) {
+  emit8(e, rex(false, src, dst));
+  emit8(e, op);
+  emit8(e, modrm(3, src, dst));
+}
+
+/* <op> dst8, imm8, with the operation selected by the ModRM reg field. */
+static void emit_alu8_imm(Emitter *e, uint8_t ext, uint8_t dst, uint8_t imm) {
+  emit8(e, rex(false, 0, dst));
+  emit8(e, 0x80);
+  emit8(e, modrm(3, ext, dst));
+  emit8(e, imm);
+}
+
+/* set<cc> dst8 */
+static void emit_setcc(Emitter *e, uint8_t cc, uint8_t dst) {
+  emit8(e, rex(false, 0, dst));
+  emit8(e, 0x0F);
+  emit8(e, 0x90 + cc);
+  emit8(e, modrm(3, 0, dst));
+}
+
+static void emit_push(Emitter *e, uint8_t reg) {
+  if (reg >= 8) {
+    emit8(e, rex(false, 0, reg));
+  }
+  emit8(e, 0x50 + (reg & 7));
+}
+
+static void emit_pop(Emitter *e, uint8_t reg) {
+  if (reg >= 8) {
+    emit8(e, rex(false, 0, reg));
+  }
+  emit8(e, 0x58 + (reg & 7));
+}
+
+static uint32_t slot_offset(uint8_t slot) {
+  if (slot == SLOT_I) {
+    return offsetof(Chip8, ir);
+  }
+  return offsetof(Chip8, registers) + slot;
+}
+
+/**
+ * @brief Lists the slots used by an instruction that can be translated.
+ *
+ * @param quirks The quirks of the profile of the ROM.
+ * @param inst The decoded instruction.
+ * @param slots The slots used by the instruction.
+ * @param ends Set if the instruction has to be the last one of the block.
+ * @return The number of slots, or -1 if the instruction can't be translated.
+ */
+static int jit_inst_slots(const Chip8Quirks *quirks, const Chip8Inst *inst,
+                          uint8_t *slots, bool *ends) {
+  *ends = false;
+
+  switch (inst->kind) {
+  case CHIP8_OP_IGNORE:
+    return 0;
+  case CHIP8_OP_1NNN:
+    *ends = true;
+    return 0;
+  case CHIP8_OP_3XKK:
+  case CHIP8_OP_4XKK:
+    *ends = true;
+    slots[0] = inst->x;
+    return 1;
+  case CHIP8_OP_5XY0:
+  case CHIP8_OP_9XY0:
+    *ends = true;
+    slots[0] = inst->x;
+    slots[1] = inst->y;
+    return 2;
+  case CHIP8_OP_6XKK:
+  case CHIP8_OP_7XKK:
+    slots[0] = inst->x;
+    return 1;
+  case CHIP8_OP_8XY0:
+    slots[0] = inst->x;
+    slots[1] = inst->y;
+    return 2;
+  case CHIP8_OP_8XY1:
+  case CHIP8_OP_8XY2:
+  case CHIP8_OP_8XY3:
+    slots[0] = inst->x;
+    slots[1] = inst->y;
+    slots[2] = VF;
+    return quirks->vf_reset ? 3 : 2;
+  case CHIP8_OP_8XY4:
+  case CHIP8_OP_8XY5:
+  case CHIP8_OP_8XY7:
+    slots[0] = inst->x;
+    slots[1] = inst->y;
+    slots[2] = VF;
+    return 3;
+  case CHIP8_OP_8XY6:
+    slots[0] = inst->x;
+    slots[1] = VF;
+    slots[2] = inst->y;
+    return quirks->shift_vy ? 3 : 2;
+  case CHIP8_OP_ANNN:
+    slots[0] = SLOT_I;
+    return 1;
+  case CHIP8_OP_FX1E:
+    slots[0] = SLOT_I;
+    slots[1] = inst->x;
+    return 2;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Emits the native code of a single instruction.
+ *
+ * @param e The emitter.
+ * @param quirks The quirks of the profile of the ROM, which are checked here
+ * rather than in the translated code.
+ * @param inst The decoded instruction.
+ * @param skip_cc Set to the condition under which the next instruction is
+ * skipped, for the skip instructions.
+ */
+static void jit_emit_inst(Emitter *e, const Chip8Quirks *quirks,
+                          const Chip8Inst *inst, int *skip_cc) {
+  uint8_t x = e->host[inst->x];
+  uint8_t y = e->host[inst->y];
+  uint8_t f = e->host[VF];
+  uint8_t i = e->host[SLOT_I];
+
+  switch (inst->kind) {
+  case CHIP8_OP_3XKK:
+    emit_alu8_imm(e, 7, x, inst->kk); /* cmp */
+    *skip_cc = CC_E;
+    break;
+  case CHIP8_OP_4XKK:
+    emit_alu8_imm(e, 7, x, inst->kk); /* cmp */
+    *skip_cc = CC_NE;
+    break;
+  case CHIP8_OP_5XY0:
+    emit_alu8(e, 0x38, x, y); /* cmp */
+    *skip_cc = CC_E;
+    break;
+  case CHIP8_OP_9XY0:
+    emit_alu8(e, 0x38, x, y); /* cmp */
+    *skip_cc = CC_NE;
+    break;
+  case CHIP8_OP_6XKK:
+    emit_mov_imm(e, x, inst->kk);
+    e->dirty[inst->x] = true;
+    break;
+  case CHIP8_OP_7XKK:
+    emit_alu8_imm(e, 0, x, inst->kk); /* add */
+    e->dirty[inst->x] = true;
+    break;
+  case CHIP8_OP_8XY0:
+    emit_alu8(e, 0x88, x, y); /* mov */
+    e->dirty[inst->x] = true;
+    break;
+  case CHIP8_OP_8XY1:
+    emit_alu8(e, 0x08, x, y); /* or */
+    e->dirty[inst->x] = true;
+    if (quirks->vf_reset) {
+      emit_mov_imm(e, f, 0);
+      e->dirty[VF] = true;
+    }
+    break;
+  case CHIP8_OP_8XY2:
+    emit_alu8(e, 0x20, x, y); /* and */
+    e->dirty[inst->x] = true;
+    if (quirks->vf_reset) {
+      emit_mov_imm(e, f, 0);
+      e->dirty[VF] = true;
+    }
+    break;
+  case CHIP8_OP_8XY3:
+    emit_alu8(e, 0x30, x, y); /* xor */
+    e->dirty[inst->x] = true;
+    if (quirks->vf_reset) {
+      emit_mov_imm(e, f, 0);
+      e->dirty[VF] = true;
+    }
+    break;
+  case CHIP8_OP_8XY4:
+    /* VF is the carry of the addition. */
+    emit_alu8(e, 0x00, x, y); /* add */
+    emit_setcc(e, CC_C, f);
+    e->dirty[inst->x] = e->dirty[VF] = true;
+    break;
+  case CHIP8_OP_8XY5:
+    /* VF is set if Vx was above Vy, which the flags of the subtraction keep. */
+    emit_alu8(e, 0x28, x, y); /* sub */
+    emit_setcc(e, CC_A, f);
+    e->dirty[inst->x] = e->dirty[VF] = true;
+    break;
+  case CHIP8_OP_8XY6:
+    if (quirks->shift_vy) {
+      emit_alu8(e, 0x88, x, y); /* mov */
+    }
+    /* VF is the bit shifted out into the carry. */
+    emit8(e, rex(false, 0, x));
+    emit8(e, 0xD0);
+    emit8(e, modrm(3, 5, x)); /* shr x, 1 */
+    emit_setcc(e, CC_C, f);
+    e->dirty[inst->x] = e->dirty[VF] = true;
+    break;
+  case CHIP8_OP_8XY7:
+    /* Vy - Vx is computed in the scratch register, as VF is set after Vx. */
+    emit_alu8(e, 0x88, R11, y); /* mov */
+    emit_alu8(e, 0x28, R11, x); /* sub */
+    emit_alu8(e, 0x88, x, R11); /* mov */
+    emit_setcc(e, CC_A, f);
+    e->dirty[inst->x] = e->dirty[VF] = true;
+    break;
+  case CHIP8_OP_ANNN:
+    emit_mov_imm(e, i, inst->nnn);
+    e->dirty[SLOT_I] = true;
+    break;
+  case CHIP8_OP_FX1E:
+    /* movzx r11d, x8 ; add i32, r11d */
+    emit8(e, rex(false, R11, x));
+    emit8(e, 0x0F);
+    emit8(e, 0xB6);
+    emit8(e, modrm(3, R11, x));
+    emit8(e, rex(false, R11, i));
+    emit8(e, 0x01);
+    emit8(e, modrm(3, R11, i));
+    e->dirty[SLOT_I] = true;
+    break;
+  }
+}
+
+/**
+ * @brief Drops every translated block and starts over with empty code memory.
+ */
+static void jit_flush(Chip8Jit *jit) {
+  for (uint32_t i = 0; i < CHIP8_DECODED_SIZE; i++) {
+    jit->blocks[i].code = NULL;
+    jit->blocks[i].hits = 0;
+    jit->cover[i] = 0;
+  }
+  jit->used = 0;
+}
+
+/**
+ * @brief Translates the block that starts at an even address to native code.
+ *
+ * The block runs from the start address up to the first instruction that
+ * can't be translated, or that needs more host registers than are left. The
+ * Chip-8 registers the block uses are loaded into host registers once when it's
+ * entered, and the ones it changed are stored back once when it exits.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param start The address of the first instruction of the block.
+ * @return True if the block was translated.
+ */
+static bool jit_compile(Chip8 *self, uint16_t start) {
+#if defined(__x86_64__) && defined(__linux__)
+  Chip8Jit *jit = self->jit;
+  Chip8JitBlock *block = &jit->blocks[start >> 1];
+  JitInst insts[CHIP8_JIT_MAX_LENGTH];
+  uint16_t length = 0;
+  uint16_t addr = start;
+  Emitter e = {.used = 0};
+
+  memset(e.host, -1, sizeof(e.host));
+
+  /* Find the instructions of the block, and allocate their host registers. */
+  /* The last two instructions of the memory are left to the interpreter, so
+   * that the end of every block fits in 16 bits, skipped instruction
+   * included. */
+  while (length < CHIP8_JIT_MAX_LENGTH && addr < CHIP8_MEMORY_SIZE - 4) {
+    JitInst *ji = &insts[length];
+    bool ends;
+
+    chip8_decode(self->memory[addr] << 8 | self->memory[addr + 1], &ji->inst);
+    int count = jit_inst_slots(self->quirks, &ji->inst, ji->slots, &ends);
+    if (count < 0) {
+      break;
+    }
+    if (ji->inst.kind == CHIP8_OP_1NNN &&
+        chip8_idle_jump(self->memory, addr, ji->inst.nnn)) {
+      break;
+    }
+
+    uint8_t needed = 0;
+    for (int s = 0; s < count; s++) {
+      needed += e.host[ji->slots[s]] < 0;
+    }
+    if (e.used + needed > HOST_REG_COUNT) {
+      break;
+    }
+    for (int s = 0; s < count; s++) {
+      if (e.host[ji->slots[s]] < 0) {
+        e.host[ji->slots[s]] = host_regs[e.used++];
+      }
+    }
+
+    length++;
+    addr += 2;
+    if (ends) {
+      break;
+    }
+  }
+
+  if (length == 0) {
+    block->untranslatable = 1;
+    return false;
+  }
+
+  if (jit->used + MAX_BLOCK_CODE > CHIP8_JIT_CODE_SIZE) {
+    jit_flush(jit);
+  }
+
+  if (mprotect(jit->code, CHIP8_JIT_CODE_SIZE, PROT_READ | PROT_WRITE) != 0) {
+    block->untranslatable = 1;
+    return false;
+  }
+
+  e.code = jit->code + jit->used;
+
+  /* Prologue: save the callee-saved registers, and load the slots. */
+  emit_push(&e, RBX);
+  emit_push(&e, RBP);
+  emit_push(&e, R12);
+  emit_push(&e, R13);
+  emit_push(&e, R14);
+  emit_push(&e, R15);
+  for (uint8_t slot = 0; slot < SLOT_COUNT; slot++) {
+    if (e.host[slot] >= 0) {
+      emit_load(&e, e.host[slot], slot_offset(slot), slot == SLOT_I);
+    }
+  }
+
+  int skip_cc = -1;
+  for (uint16_t i = 0; i < length; i++) {
+    jit_emit_inst(&e, self->quirks, &insts[i].inst, &skip_cc);
+  }
+
+  /* Epilogue: store the changed slots, which doesn't touch the flags of a
+   * skip instruction, and then the PC. */
+  for (uint8_t slot = 0; slot < SLOT_COUNT; slot++) {
+    if (e.dirty[slot]) {
+      emit_store(&e, e.host[slot], slot_offset(slot), slot == SLOT_I);
+    }
+  }
+
+  const Chip8Inst *last = &insts[length - 1].inst;
+  uint32_t next_pc = last->kind == CHIP8_OP_1NNN ? last->nnn : addr;
+  uint16_t end = addr;
+  emit_mov_imm(&e, RAX, next_pc);
+  if (skip_cc >= 0) {
+    /* XO-CHIP skips F000 nnnn as a whole, so the skipped instruction is part
+     * of the translation, and dropping it has to drop the block too. */
+    uint8_t skip = 2;
+    if (self->quirks->xochip) {
+      skip = self->memory[addr] == 0xF0 && self->memory[addr + 1] == 0 ? 4 : 2;
+      end = addr + 2;
+    }
+
+    /* j<not cc> over the add eax, skip */
+    emit8(&e, 0x70 + (skip_cc ^ 1));
+    emit8(&e, 3);
+    emit8(&e, 0x83);
+    emit8(&e, modrm(3, 0, RAX));
+    emit8(&e, skip);
+  }
+  emit_store(&e, RAX, offsetof(Chip8, pc), true);
+
+  emit_pop(&e, R15);
+  emit_pop(&e, R14);
+  emit_pop(&e, R13);
+  emit_pop(&e, R12);
+  emit_pop(&e, RBP);
+  emit_pop(&e, RBX);
+  emit_mov_imm(&e, RAX, length);
+  emit8(&e, 0xC3); /* ret */
+
+  if (mprotect(jit->code, CHIP8_JIT_CODE_SIZE, PROT_READ | PROT_EXEC) != 0) {
+    block->untranslatable = 1;
+    return false;
+  }
+
+  block->code = (chip8_jit_code)(void *)e.code;
+  block->end = end;
+  block->length = length;
+  jit->used += (e.pos + 15) & ~15u;
+
+  for (addr = start; addr < block->end; addr += 2) {
+    jit->cover[addr >> 1]++;
+  }
+
+  return true;
+#else
+  self->jit->blocks[start >> 1].untranslatable = 1;
+  return false;
+#endif
+}
+
+/**
+ * @brief Drops the translated blocks that contain a written address.
+ *
+ * Called for every address written by an instruction, so that self-modifying
+ * code is translated again from the new instructions.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param addr The written address.
+ */
+void chip8_jit_invalidate(Chip8 *self, uint16_t addr) {
+  Chip8Jit *jit = self->jit;
+  uint16_t index = (addr & (CHIP8_MEMORY_SIZE - 1)) >> 1;
+
+  /* The new instruction might be translatable. */
+  jit->blocks[index].untranslatable = 0;
+  jit->blocks[index].hits = 0;
+
+  if (jit->cover[index] == 0) {
+    return;
+  }
+
+  /* A block that covers the index can't start further back than this, with
+   * the instruction skipped at its end. */
+  uint16_t first =
+      index >= CHIP8_JIT_MAX_LENGTH ? index - CHIP8_JIT_MAX_LENGTH : 0;
+
+  for (uint16_t start = first; start <= index; start++) {
+    Chip8JitBlock *block = &jit->blocks[start];
+    if (block->code != NULL && block->end > (index << 1)) {
+      for (uint16_t a = start << 1; a < block->end; a += 2) {
+        jit->cover[a >> 1]--;
+      }
+      block->code = NULL;
+      block->hits = 0;
+    }
+  }
+}
+
+/**
+ * @brief Releases the translated code and the state of the JIT.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_jit_free(Chip8 *self) {
+  if (self->jit == NULL) {
+    return;
+  }
+
+  if (self->jit->code != NULL) {
+    munmap(self->jit->code, CHIP8_JIT_CODE_SIZE);
+  }
+  free(self->jit);
+  self->jit = NULL;
+}
+
+/**
+ * @brief Sets up the state of the JIT, on its first use.
+ *
+ * @return False if the state couldn't be allocated.
+ */
+static bool jit_init(Chip8 *self) {
+  self->jit = calloc(1, sizeof(*self->jit));
+  if (self->jit == NULL) {
+    return false;
+  }
+
+  void *code = mmap(NULL, CHIP8_JIT_CODE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED) {
+    /* Nothing gets translated, and every instruction is interpreted. */
+    for (uint32_t i = 0; i < CHIP8_DECODED_SIZE; i++) {
+      self->jit->blocks[i].untranslatable = 1;
+    }
+  } else {
+    self->jit->code = code;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Executes instructions, translating the hot blocks to native x86-64
+ * code.
+ *
+ * Every block is interpreted until it was entered CHIP8_JIT_HOT_THRESHOLD
+ * times, and is then translated and run natively from there on. Anything that
+ * can't be translated, including the blocks that are longer than the remaining
+ * count, is executed by chip8_inst_emulate().
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param count The number of instructions to be executed.
+ * @return The number of executed instructions.
+ */
+uint32_t chip8_execute_jit(Chip8 *self, uint32_t count) {
+  uint32_t executed = 0;
+
+  if (self->jit == NULL && !jit_init(self)) {
+    return chip8_execute_table(self, count);
+  }
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  while (executed < count && self->stop == CHIP8_STOP_BUDGET) {
+    uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+
+    if ((pc & 1) == 0) {
+      Chip8JitBlock *block = &self->jit->blocks[pc >> 1];
+
+      if (block->code == NULL && !block->untranslatable &&
+          ++block->hits >= CHIP8_JIT_HOT_THRESHOLD) {
+        jit_compile(self, pc);
+      }
+
+      /* The translated code never reads the timers, so its cycles are only
+       * counted once it's done. */
+      if (block->code != NULL && block->length <= count - executed) {
+        uint32_t length = block->code(self);
+        self->cycles += length;
+        executed += length;
+        continue;
+      }
+    }
+
+    chip8_parse_code(self);
+    chip8_inst_emulate(self);
+    self->cycles++;
+    executed++;
+  }
+
+  return executed;
+}
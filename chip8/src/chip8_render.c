@@ -0,0 +1,168 @@
+#include "chip8_render.h"
+#include "chip8.h"
+#include "chip8_log.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The colours of the pixels lit in more than the first plane, from the palette
+ * of Octo for the first two planes. */
+static const Chip8Rgba chip8_render_colours[CHIP8_COLOURS] = {
+    [2] = {0xFF, 0x66, 0x00, 0xFF},  [3] = {0x66, 0x22, 0x00, 0xFF},
+    [4] = {0x00, 0x99, 0xFF, 0xFF},  [5] = {0x00, 0x55, 0x88, 0xFF},
+    [6] = {0xAA, 0x44, 0xFF, 0xFF},  [7] = {0x55, 0x22, 0x88, 0xFF},
+    [8] = {0xFF, 0x00, 0x66, 0xFF},  [9] = {0x88, 0x00, 0x33, 0xFF},
+    [10] = {0xFF, 0xFF, 0x99, 0xFF}, [11] = {0x99, 0x99, 0x55, 0xFF},
+    [12] = {0x99, 0xFF, 0x99, 0xFF}, [13] = {0x55, 0x99, 0x55, 0xFF},
+    [14] = {0xFF, 0xFF, 0xFF, 0xFF}, [15] = {0x88, 0x88, 0x88, 0xFF},
+};
+
+/**
+ * @brief Allocates the RGBA buffer of the screen.
+ *
+ * @param self A pointer to the Chip8Render object.
+ * @param scale The size of a pixel of the screen, in pixels.
+ * @param rounded Set to cut the corners of the lit pixels, when they're at
+ * least 3 pixels wide.
+ * @param off The colour of the unlit pixels.
+ * @param on The colour of the lit pixels, when only the first plane is drawn
+ * on. The other XO-CHIP colours can be changed in the palette afterwards.
+ * @return 0 on success, 1 otherwise.
+ */
+int chip8_render_init(Chip8Render *self, uint8_t scale, uint8_t rounded,
+                      Chip8Rgba off, Chip8Rgba on) {
+  memcpy(self->palette, chip8_render_colours, sizeof(self->palette));
+  self->palette[0] = off;
+  self->palette[1] = on;
+  self->scale = scale;
+  self->rounded = rounded;
+  self->width = CHIP8_SCREEN_WIDTH * scale;
+  self->height = CHIP8_SCREEN_HEIGHT * scale;
+  self->pixels = malloc((size_t)self->width * self->height * sizeof(Chip8Rgba));
+
+  if (self->pixels == NULL) {
+    CHIP8_LOG_ERROR("Can't allocate the %ux%u screen buffer.\n", self->width,
+                    self->height);
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Returns the width of the screen in its current mode.
+ */
+static uint8_t chip8_render_screen_width(const Chip8Screen *screen) {
+  return screen->hires ? CHIP8_HIRES_WIDTH : CHIP8_SCREEN_WIDTH;
+}
+
+/**
+ * @brief Returns the colour of a pixel of the screen, with bit p set if it's
+ * lit in plane p.
+ */
+static uint8_t chip8_render_pixel(const Chip8Screen *screen, uint8_t x,
+                                  uint8_t y) {
+  uint8_t colour = 0;
+
+  for (uint8_t p = 0; p < CHIP8_PLANES; p++) {
+    colour |= ((screen->graphics[p][x / 64][y] >> (63 - x % 64)) & 1) << p;
+  }
+
+  return colour;
+}
+
+/**
+ * @brief Returns the size of a pixel of the screen in the current mode.
+ *
+ * The buffer is sized for the low resolution screen, so the pixels are half
+ * as big in the high resolution mode.
+ *
+ * @param self A pointer to the Chip8Render object.
+ * @param screen A pointer to the Chip8Screen object.
+ */
+uint8_t chip8_render_cell(const Chip8Render *self, const Chip8Screen *screen) {
+  return self->width / chip8_render_screen_width(screen);
+}
+
+/**
+ * @brief Converts rows of the screen to RGBA pixels.
+ *
+ * Every row of the screen is converted to its first line of pixels, which is
+ * then copied to the other lines of the row, before the corners are cut.
+ *
+ * @param self A pointer to the Chip8Render object.
+ * @param screen A pointer to the Chip8Screen object.
+ * @param rows A bit mask of the rows to convert, such as its dirty rows.
+ */
+void chip8_render_rows(Chip8Render *self, const Chip8Screen *screen,
+                       uint64_t rows) {
+  uint8_t width = chip8_render_screen_width(screen);
+  uint8_t height = screen->hires ? CHIP8_HIRES_HEIGHT : CHIP8_SCREEN_HEIGHT;
+  uint8_t cell = chip8_render_cell(self, screen);
+  uint8_t rounded = self->rounded && cell >= 3;
+  size_t line_size = self->width * sizeof(Chip8Rgba);
+
+  for (int y = 0; y < height; y++) {
+    if (!(rows & (1ULL << y))) {
+      continue;
+    }
+
+    uint8_t lit = 0;
+    Chip8Rgba *first = &self->pixels[(size_t)y * cell * self->width];
+    Chip8Rgba *out = first;
+
+    for (int w = 0; w < width / 64; w++) {
+      uint64_t word = screen->graphics[0][w][y];
+      uint64_t others = 0;
+
+      for (int p = 1; p < CHIP8_PLANES; p++) {
+        others |= screen->graphics[p][w][y];
+      }
+      lit |= (word | others) != 0;
+
+      for (int x = 63; x >= 0; x--) {
+        uint8_t index = (word >> x) & 1;
+
+        /* Most of the rows are only drawn on the first plane. */
+        if (others != 0) {
+          for (int p = 1; p < CHIP8_PLANES; p++) {
+            index |= ((screen->graphics[p][w][y] >> x) & 1) << p;
+          }
+        }
+
+        Chip8Rgba colour = self->palette[index];
+
+        for (uint8_t i = 0; i < cell; i++) {
+          *out++ = colour;
+        }
+      }
+    }
+
+    for (uint8_t i = 1; i < cell; i++) {
+      memcpy(&first[i * self->width], first, line_size);
+    }
+
+    if (!rounded || !lit) {
+      continue;
+    }
+
+    Chip8Rgba *last = &first[(cell - 1) * self->width];
+
+    for (int x = 0; x < width; x++) {
+      if (chip8_render_pixel(screen, x, y)) {
+        first[x * cell] = first[x * cell + cell - 1] = self->palette[0];
+        last[x * cell] = last[x * cell + cell - 1] = self->palette[0];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Frees the RGBA buffer of the screen.
+ *
+ * @param self A pointer to the Chip8Render object.
+ */
+void chip8_render_deinit(Chip8Render *self) {
+  free(self->pixels);
+  self->pixels = NULL;
+}
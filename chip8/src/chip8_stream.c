@@ -0,0 +1,531 @@
+#include "chip8_stream.h"
+#include "chip8.h"
+#include "chip8_log.h"
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The grey levels of the colours in Y4M streams, white for the pixels only lit
+ * in the first plane and darker for the other colours. */
+const uint8_t chip8_stream_luma[CHIP8_COLOURS] = {
+    0,   255, 239, 223, 207, 191, 175, 159,
+    143, 127, 111, 95,  79,  63,  47,  31,
+};
+
+/**
+ * @brief Returns the size of the packed rows of a plane of a frame.
+ */
+static size_t chip8_stream_plane_size(const Chip8Stream *self) {
+  return (size_t)self->width * self->height / 8;
+}
+
+/**
+ * @brief Doubles every bit of a 32-bit word, to draw a low resolution row in
+ * a high resolution stream.
+ */
+static uint64_t chip8_stream_double(uint32_t bits) {
+  uint64_t x = bits;
+
+  x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+  x = (x | x << 8) & 0x00FF00FF00FF00FFULL;
+  x = (x | x << 4) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+
+  return x | x << 1;
+}
+
+/**
+ * @brief Packs planes of a frame into rows of 1 bit per pixel, the leftmost
+ * pixel in the most significant bit of the first byte.
+ *
+ * The words of the screen are already packed that way, so a row is the words
+ * of the planes ORed together and stored in big-endian order. The pixels of a
+ * low resolution frame in a high resolution stream are doubled.
+ *
+ * @return 1 if any pixel is lit, 0 otherwise.
+ */
+static uint8_t chip8_stream_pack(const Chip8Stream *self,
+                                 const Chip8StreamFrame *frame, uint8_t planes,
+                                 uint8_t *out) {
+  uint8_t scale = frame->hires ? 1 : self->width / CHIP8_SCREEN_WIDTH;
+  size_t line_size = self->width / 8;
+  uint64_t lit = 0;
+
+  for (int y = 0; y < self->height / scale; y++) {
+    uint8_t *line = out;
+
+    for (int w = 0; w < self->width / 64 / scale; w++) {
+      uint64_t word = 0;
+
+      for (int p = 0; p < CHIP8_PLANES; p++) {
+        if (planes & (1 << p)) {
+          word |= frame->graphics[p][w][y];
+        }
+      }
+      lit |= word;
+
+      if (scale == 1) {
+        word = __builtin_bswap64(word);
+        memcpy(out, &word, sizeof(word));
+        out += sizeof(word);
+      } else {
+        uint64_t left = __builtin_bswap64(chip8_stream_double(word >> 32));
+        uint64_t right = __builtin_bswap64(chip8_stream_double(word));
+        memcpy(out, &left, sizeof(left));
+        memcpy(out + sizeof(left), &right, sizeof(right));
+        out += sizeof(left) + sizeof(right);
+      }
+    }
+
+    if (scale == 2) {
+      memcpy(out, line, line_size);
+      out += line_size;
+    }
+  }
+
+  return lit != 0;
+}
+
+/**
+ * @brief Converts a frame to one grey byte per pixel.
+ */
+static void chip8_stream_grey(const Chip8Stream *self,
+                              const Chip8StreamFrame *frame, uint8_t *out) {
+  uint8_t scale = frame->hires ? 1 : self->width / CHIP8_SCREEN_WIDTH;
+
+  for (int y = 0; y < self->height; y++) {
+    for (int x = 0; x < self->width; x++) {
+      uint8_t fx = x / scale;
+      uint8_t colour = 0;
+
+      for (int p = 0; p < CHIP8_PLANES; p++) {
+        uint64_t word = frame->graphics[p][fx / 64][y / scale];
+        colour |= ((word >> (63 - fx % 64)) & 1) << p;
+      }
+
+      *out++ = chip8_stream_luma[colour];
+    }
+  }
+}
+
+/**
+ * @brief Encodes bytes with PackBits.
+ *
+ * A control byte n from 0 to 127 is followed by n + 1 bytes copied as they
+ * are, and a control byte n from 129 to 255 by a byte repeated 257 - n times.
+ * The rows of a CHIP-8 frame are mostly runs of blank bytes.
+ *
+ * @param in The bytes to encode.
+ * @param size The number of bytes to encode.
+ * @param out The encoded bytes, at most size + size / 128 + 1 of them.
+ * @return The number of encoded bytes.
+ */
+size_t chip8_stream_packbits(const uint8_t *in, size_t size, uint8_t *out) {
+  size_t written = 0;
+  size_t i = 0;
+
+  while (i < size) {
+    size_t run = 1;
+    while (i + run < size && run < 128 && in[i + run] == in[i]) {
+      run++;
+    }
+
+    if (run >= 2) {
+      out[written++] = (uint8_t)(257 - run);
+      out[written++] = in[i];
+      i += run;
+      continue;
+    }
+
+    /* Copy up to the next run of 3 bytes. Shorter runs are cheaper inside the
+     * copy, and keep the encoded bytes from growing by more than 1 in 128. */
+    size_t count = 1;
+    while (i + count < size && count < 128 &&
+           !(i + count + 2 < size && in[i + count] == in[i + count + 1] &&
+             in[i + count] == in[i + count + 2])) {
+      count++;
+    }
+
+    out[written++] = (uint8_t)(count - 1);
+    memcpy(&out[written], &in[i], count);
+    written += count;
+    i += count;
+  }
+
+  return written;
+}
+
+/**
+ * @brief Decodes bytes encoded with chip8_stream_packbits().
+ *
+ * @param in The encoded bytes.
+ * @param size The number of encoded bytes.
+ * @param out The decoded bytes.
+ * @param capacity The size of the decoded buffer.
+ * @return The number of decoded bytes, or capacity + 1 if they don't fit or
+ * the encoded bytes are truncated.
+ */
+size_t chip8_stream_unpackbits(const uint8_t *in, size_t size, uint8_t *out,
+                               size_t capacity) {
+  size_t written = 0;
+  size_t i = 0;
+
+  while (i < size) {
+    uint8_t control = in[i++];
+
+    if (control < 128) {
+      size_t count = control + 1;
+      if (i + count > size || written + count > capacity) {
+        return capacity + 1;
+      }
+      memcpy(&out[written], &in[i], count);
+      i += count;
+      written += count;
+    } else if (control > 128) {
+      size_t count = 257 - control;
+      if (i >= size || written + count > capacity) {
+        return capacity + 1;
+      }
+      memset(&out[written], in[i++], count);
+      written += count;
+    }
+  }
+
+  return written;
+}
+
+/**
+ * @brief Converts a frame to the format of the stream, in its buffer.
+ *
+ * The frames of the raw, PBM and Y4M streams keep their header at the start of
+ * the buffer. The frames of RLE recordings get the header of their own, and
+ * only the planes with lit pixels are recorded, one after the other, or the
+ * first one if none has.
+ */
+static void chip8_stream_convert(Chip8Stream *self,
+                                 const Chip8StreamFrame *frame) {
+  size_t plane_size = chip8_stream_plane_size(self);
+
+  switch (self->format) {
+  case CHIP8_STREAM_RAW:
+  case CHIP8_STREAM_PBM:
+    chip8_stream_pack(self, frame, (1 << CHIP8_PLANES) - 1,
+                      self->buffer + self->size - plane_size);
+    break;
+  case CHIP8_STREAM_Y4M:
+    chip8_stream_grey(self, frame,
+                      self->buffer + self->size - plane_size * 8);
+    break;
+  case CHIP8_STREAM_RLE: {
+    Chip8StreamRleFrame header = {.time = frame->time};
+    size_t size = sizeof(header);
+
+    for (int p = 0; p < CHIP8_PLANES; p++) {
+      if (chip8_stream_pack(self, frame, 1 << p, self->scratch)) {
+        header.planes |= 1 << p;
+        size += chip8_stream_packbits(self->scratch, plane_size,
+                                      &self->buffer[size]);
+      }
+    }
+
+    /* A header without planes would end the recording. */
+    if (header.planes == 0) {
+      memset(self->scratch, 0, plane_size);
+      header.planes = 1;
+      size += chip8_stream_packbits(self->scratch, plane_size,
+                                    &self->buffer[size]);
+    }
+
+    header.size = size - sizeof(header);
+    memcpy(self->buffer, &header, sizeof(header));
+    self->size = size;
+    break;
+  }
+  }
+}
+
+/**
+ * @brief Writes a whole buffer, across the short writes of pipes.
+ *
+ * @return 0 on success, 1 otherwise.
+ */
+static int chip8_stream_write(int fd, const void *data, size_t size) {
+  const uint8_t *bytes = data;
+
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 1;
+    }
+
+    bytes += written;
+    size -= written;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Writes the header of the stream, if its format has one.
+ *
+ * @return 0 on success, 1 otherwise.
+ */
+static int chip8_stream_write_header(Chip8Stream *self) {
+  if (self->format == CHIP8_STREAM_Y4M) {
+    char header[64];
+    int size = snprintf(header, sizeof(header),
+                        "YUV4MPEG2 W%u H%u F60:1 Ip A1:1 Cmono\n", self->width,
+                        self->height);
+    return chip8_stream_write(self->fd, header, size);
+  }
+
+  if (self->format == CHIP8_STREAM_RLE) {
+    Chip8StreamRleHeader header = {.width = self->width,
+                                   .height = self->height,
+                                   .rate = 60};
+    memcpy(header.magic, CHIP8_STREAM_RLE_MAGIC, sizeof(header.magic));
+    return chip8_stream_write(self->fd, &header, sizeof(header));
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Writes the queued frames until the stream is closed.
+ *
+ * The writer sleeps on the semaphore until a frame is queued, and takes it off
+ * the queue once it's written. A repeated frame is written again from the
+ * buffer, without converting it. Once a write failed, the frames are still
+ * taken off the queue, and dropped.
+ */
+static void *chip8_stream_writer(void *arg) {
+  Chip8Stream *self = arg;
+  uint8_t failed = chip8_stream_write_header(self);
+
+  if (failed) {
+    CHIP8_LOG_ERROR("Can't write the frame stream: %s\n", strerror(errno));
+    atomic_store_explicit(&self->failed, 1, memory_order_release);
+  }
+
+  for (;;) {
+    while (sem_wait(&self->queued) != 0 && errno == EINTR) {
+    }
+
+    uint32_t tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+
+    /* The semaphore was posted without a frame to close the stream. */
+    if (tail == atomic_load_explicit(&self->head, memory_order_acquire)) {
+      break;
+    }
+
+    const Chip8StreamFrame *frame =
+        &self->frames[tail % CHIP8_STREAM_QUEUE_SIZE];
+
+    if (!failed) {
+      if (!frame->repeat) {
+        chip8_stream_convert(self, frame);
+      }
+
+      failed = chip8_stream_write(self->fd, self->buffer, self->size);
+      if (failed) {
+        CHIP8_LOG_ERROR("Can't write the frame stream: %s\n", strerror(errno));
+        atomic_store_explicit(&self->failed, 1, memory_order_release);
+      }
+    }
+
+    atomic_store_explicit(&self->tail, tail + 1, memory_order_release);
+    sem_post(&self->written);
+  }
+
+  /* The frames left out of a recording repeat the last one recorded. */
+  if (!failed && self->format == CHIP8_STREAM_RLE) {
+    Chip8StreamRleFrame end = {.time = self->count};
+    chip8_stream_write(self->fd, &end, sizeof(end));
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Starts streaming frames to a file or a pipe.
+ *
+ * Every frame is the same size, so the streams of ROMs that can switch to the
+ * high resolution mode are 128x64, and their low resolution frames have their
+ * pixels doubled. The rows are packed 1 bit per pixel in raw and PBM streams,
+ * with 1 for a pixel lit in any plane, which PBM shows black. Y4M streams have
+ * one grey byte per pixel, at 60 frames per second. RLE recordings keep every
+ * plane, and only the frames that changed, with their number.
+ *
+ * A live stream drops the frames its reader can't keep up with, while a
+ * recording opened with wait set holds up the emulation instead, so that it
+ * gets every frame.
+ *
+ * @param self A pointer to the Chip8Stream object.
+ * @param fd The file descriptor to write to, closed by chip8_stream_close().
+ * @param format The Chip8StreamFormat of the frames.
+ * @param hires Set if the ROM can switch to the high resolution mode.
+ * @param wait Set to wait for the writer when the queue is full, instead of
+ * dropping the frame.
+ * @return 0 on success, 1 otherwise.
+ */
+int chip8_stream_open(Chip8Stream *self, int fd, Chip8StreamFormat format,
+                      uint8_t hires, uint8_t wait) {
+  memset(self, 0, sizeof(*self));
+  self->fd = fd;
+  self->format = format;
+  self->wait = wait;
+  self->width = hires ? CHIP8_HIRES_WIDTH : CHIP8_SCREEN_WIDTH;
+  self->height = hires ? CHIP8_HIRES_HEIGHT : CHIP8_SCREEN_HEIGHT;
+  atomic_init(&self->head, 0);
+  atomic_init(&self->tail, 0);
+  atomic_init(&self->failed, 0);
+
+  size_t plane_size = chip8_stream_plane_size(self);
+  char header[32] = "";
+  size_t capacity;
+
+  if (format == CHIP8_STREAM_PBM) {
+    snprintf(header, sizeof(header), "P4\n%u %u\n", self->width, self->height);
+  } else if (format == CHIP8_STREAM_Y4M) {
+    snprintf(header, sizeof(header), "FRAME\n");
+  }
+
+  if (format == CHIP8_STREAM_RLE) {
+    capacity = sizeof(Chip8StreamRleFrame) +
+               CHIP8_PLANES * (plane_size + plane_size / 128 + 1);
+  } else if (format == CHIP8_STREAM_Y4M) {
+    capacity = strlen(header) + plane_size * 8;
+  } else {
+    capacity = strlen(header) + plane_size;
+  }
+
+  self->size = capacity;
+  self->buffer = malloc(capacity);
+  self->scratch = malloc(plane_size);
+
+  if (self->buffer == NULL || self->scratch == NULL) {
+    CHIP8_LOG_ERROR("Can't allocate the frame stream buffers.\n");
+    free(self->buffer);
+    free(self->scratch);
+    self->buffer = NULL;
+    return 1;
+  }
+  memcpy(self->buffer, header, strlen(header));
+
+  sem_init(&self->queued, 0, 0);
+  sem_init(&self->written, 0, 0);
+
+  if (pthread_create(&self->writer, NULL, chip8_stream_writer, self) != 0) {
+    CHIP8_LOG_ERROR("Can't start the frame stream writer.\n");
+    sem_destroy(&self->queued);
+    sem_destroy(&self->written);
+    free(self->buffer);
+    free(self->scratch);
+    self->buffer = NULL;
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Queues the presented frame to be written.
+ *
+ * The screen is copied into the queue, unless its hash is the same as the one
+ * of the last frame queued. Raw, PBM and Y4M streams then queue the frame
+ * without its screen, to be written again, and RLE recordings skip it. If the
+ * queue is full, the frame is dropped, so that the caller never waits for the
+ * writer and never takes a lock, unless the stream was opened with wait set:
+ * the caller then sleeps until the writer takes a frame off the queue.
+ *
+ * @param self A pointer to the Chip8Stream object.
+ * @param chip8 A pointer to the Chip8 object.
+ * @return 0 if the frame was queued or skipped, 1 if it was dropped, and -1 if
+ * the stream can't be written to anymore.
+ */
+int chip8_stream_push(Chip8Stream *self, Chip8 *chip8) {
+  uint64_t time = self->count++;
+
+  if (atomic_load_explicit(&self->failed, memory_order_acquire)) {
+    return -1;
+  }
+
+  uint64_t hash = chip8_frame_hash(chip8);
+  uint8_t repeat = self->started && hash == self->hash;
+
+  if (repeat && self->format == CHIP8_STREAM_RLE) {
+    return 0;
+  }
+
+  uint32_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+
+  /* The writer posts for every frame it takes, so this wakes up as soon as
+   * there's room, and runs through the posts of the frames taken before. */
+  while (self->wait && head - tail == CHIP8_STREAM_QUEUE_SIZE) {
+    while (sem_wait(&self->written) != 0 && errno == EINTR) {
+    }
+    tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+  }
+
+  if (head - tail == CHIP8_STREAM_QUEUE_SIZE ||
+      (chip8->hires && self->width < CHIP8_HIRES_WIDTH)) {
+    self->dropped++;
+    return 1;
+  }
+
+  Chip8StreamFrame *frame = &self->frames[head % CHIP8_STREAM_QUEUE_SIZE];
+  frame->time = time;
+  frame->repeat = repeat;
+  if (!repeat) {
+    memcpy(frame->graphics, chip8->graphics, sizeof(frame->graphics));
+    frame->hires = chip8->hires;
+  }
+  self->started = 1;
+  self->hash = hash;
+
+  atomic_store_explicit(&self->head, head + 1, memory_order_release);
+  sem_post(&self->queued);
+
+  return 0;
+}
+
+/**
+ * @brief Writes the queued frames, stops the writer and closes the file.
+ *
+ * @param self A pointer to the Chip8Stream object.
+ */
+void chip8_stream_close(Chip8Stream *self) {
+  if (self->buffer == NULL) {
+    return;
+  }
+
+  sem_post(&self->queued);
+  pthread_join(self->writer, NULL);
+  sem_destroy(&self->queued);
+  sem_destroy(&self->written);
+  close(self->fd);
+  free(self->buffer);
+  free(self->scratch);
+  self->buffer = NULL;
+
+  /* A live stream can drop frames, but a recording is missing them. */
+  if (self->dropped != 0 && self->wait) {
+    CHIP8_LOG_ERROR("Dropped %llu frames of the recording.\n",
+                    (unsigned long long)self->dropped);
+  } else if (self->dropped != 0) {
+    CHIP8_LOG_INFO("Dropped %llu frames of the stream.\n",
+                   (unsigned long long)self->dropped);
+  }
+}
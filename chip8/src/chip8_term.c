@@ -0,0 +1,198 @@
+#include "chip8_term.h"
+#include "chip8.h"
+#include "chip8_log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The longest escape sequence of a character: a cursor move to the row and
+ * column, and a character of 3 bytes in UTF-8. */
+#define CHIP8_TERM_CELL_SIZE 16
+
+/* The half blocks, indexed by the top pixel in bit 0 and the bottom one in
+ * bit 1. */
+static const char *const chip8_term_halves[4] = {" ", "▀", "▄", "█"};
+
+/* The dots of a braille pattern, indexed by the row and the column of the
+ * pixel in its character. */
+static const uint8_t chip8_term_dots[4][2] = {
+    {0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+/**
+ * @brief Starts drawing the screen in a terminal.
+ *
+ * @param self A pointer to the Chip8Term object.
+ * @param out The terminal, such as stdout.
+ * @param mode The Chip8TermMode of the characters.
+ * @return 0 on success, 1 otherwise.
+ */
+int chip8_term_init(Chip8Term *self, FILE *out, Chip8TermMode mode) {
+  memset(self, 0, sizeof(*self));
+  self->out = out;
+  self->mode = mode;
+  self->buffer = malloc(sizeof(self->cells) * CHIP8_TERM_CELL_SIZE);
+
+  if (self->buffer == NULL) {
+    CHIP8_LOG_ERROR("Can't allocate the terminal buffer.\n");
+    return 1;
+  }
+
+  /* Hide the cursor. */
+  fputs("\x1b[?25l", out);
+  fflush(out);
+
+  return 0;
+}
+
+/**
+ * @brief Returns the pixels of a row lit in any plane, 64 columns per word.
+ */
+static void chip8_term_row(const Chip8 *chip8, int y, uint64_t words[]) {
+  for (int w = 0; w < CHIP8_SCREEN_WORDS; w++) {
+    words[w] = 0;
+
+    for (int p = 0; p < CHIP8_PLANES; p++) {
+      words[w] |= chip8->graphics[p][w][y];
+    }
+  }
+}
+
+/**
+ * @brief Returns the pixels of the character at a column, from the pixel rows
+ * of its row of characters.
+ */
+static uint8_t chip8_term_cell(const Chip8Term *self,
+                               uint64_t words[][CHIP8_SCREEN_WORDS],
+                               int column) {
+  uint8_t cell = 0;
+
+  if (self->mode == CHIP8_TERM_HALF) {
+    for (int i = 0; i < 2; i++) {
+      cell |= ((words[i][column / 64] >> (63 - column % 64)) & 1) << i;
+    }
+    return cell;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 2; j++) {
+      int x = column * 2 + j;
+      if ((words[i][x / 64] >> (63 - x % 64)) & 1) {
+        cell |= chip8_term_dots[i][j];
+      }
+    }
+  }
+
+  return cell;
+}
+
+/**
+ * @brief Writes the character of a cell into a buffer.
+ *
+ * @return The number of bytes written.
+ */
+static size_t chip8_term_glyph(const Chip8Term *self, uint8_t cell,
+                               char *out) {
+  if (self->mode == CHIP8_TERM_HALF) {
+    size_t size = strlen(chip8_term_halves[cell]);
+    memcpy(out, chip8_term_halves[cell], size);
+    return size;
+  }
+
+  /* U+2800 + the dots, in UTF-8. */
+  out[0] = (char)0xE2;
+  out[1] = (char)(0xA0 | cell >> 6);
+  out[2] = (char)(0x80 | (cell & 0x3F));
+  return 3;
+}
+
+/**
+ * @brief Draws the characters that changed since the last frame.
+ *
+ * Only the rows of characters over the dirty rows are looked at, and the
+ * characters whose pixels are the same as when they were drawn are skipped.
+ * The cursor is only moved before a character that doesn't follow the one
+ * written before it, and the frame is written in a single write. The whole
+ * screen is drawn again when the resolution changes.
+ *
+ * @param self A pointer to the Chip8Term object.
+ * @param chip8 A pointer to the Chip8 object.
+ * @param dirty The rows changed since the last frame, as returned by
+ * chip8_take_dirty_rows().
+ */
+void chip8_term_draw(Chip8Term *self, const Chip8 *chip8, uint64_t dirty) {
+  uint8_t pixel_rows = self->mode == CHIP8_TERM_HALF ? 2 : 4;
+  uint8_t force = !self->drawn || self->hires != chip8->hires;
+  size_t size = 0;
+
+  if (force) {
+    self->hires = chip8->hires;
+    self->columns = chip8_screen_width(chip8) /
+                    (self->mode == CHIP8_TERM_HALF ? 1 : 2);
+    self->rows = chip8_screen_height(chip8) / pixel_rows;
+    self->drawn = 1;
+    dirty = CHIP8_ALL_ROWS;
+    size += sprintf(self->buffer, "\x1b[H\x1b[2J");
+  }
+
+  /* The cursor is nowhere after a clear, and after the last frame. */
+  int cursor_row = -1;
+  int cursor_column = -1;
+
+  for (int row = 0; row < self->rows; row++) {
+    uint64_t rows = ((1ULL << pixel_rows) - 1) << (row * pixel_rows);
+
+    if (!(dirty & rows)) {
+      continue;
+    }
+
+    uint64_t words[4][CHIP8_SCREEN_WORDS];
+    for (int i = 0; i < pixel_rows; i++) {
+      chip8_term_row(chip8, row * pixel_rows + i, words[i]);
+    }
+
+    for (int column = 0; column < self->columns; column++) {
+      uint8_t cell = chip8_term_cell(self, words, column);
+
+      /* The terminal was cleared when the whole screen is drawn. */
+      uint8_t same = force ? cell == 0 : cell == self->cells[row][column];
+      self->cells[row][column] = cell;
+      if (same) {
+        continue;
+      }
+
+      if (row != cursor_row || column != cursor_column) {
+        size += sprintf(&self->buffer[size], "\x1b[%d;%dH", row + 1,
+                        column + 1);
+      }
+      size += chip8_term_glyph(self, cell, &self->buffer[size]);
+      cursor_row = row;
+      cursor_column = column + 1;
+    }
+  }
+
+  if (size != 0) {
+    fwrite(self->buffer, size, 1, self->out);
+    fflush(self->out);
+    self->bytes += size;
+  }
+}
+
+/**
+ * @brief Shows the cursor again, below the screen, and frees the buffer.
+ *
+ * @param self A pointer to the Chip8Term object.
+ */
+void chip8_term_deinit(Chip8Term *self) {
+  if (self->buffer == NULL) {
+    return;
+  }
+
+  fprintf(self->out, "\x1b[%d;1H\x1b[?25h\n", self->rows + 1);
+  fflush(self->out);
+  free(self->buffer);
+  self->buffer = NULL;
+
+  CHIP8_LOG_INFO("Wrote %llu bytes to the terminal.\n",
+                 (unsigned long long)self->bytes);
+}
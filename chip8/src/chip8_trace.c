@@ -0,0 +1,82 @@
+#include "chip8_trace.h"
+#include "chip8.h"
+#include "chip8_log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Starts recording the executed instructions in a ring buffer.
+ *
+ * Only the engines that fetch every instruction on its own record them: the
+ * table, threaded and direct engines, chip8_run_cycles(), and the instructions
+ * the other engines leave to chip8_inst_emulate().
+ *
+ * @param self A pointer to the Chip8 object.
+ * @return 0 on success, 1 if the core was built without CHIP8_TRACE_RING or
+ * the buffer couldn't be allocated.
+ */
+int chip8_trace_start(Chip8 *self) {
+#if defined(CHIP8_TRACE_RING)
+  if (self->trace == NULL) {
+    self->trace = calloc(1, sizeof(*self->trace));
+  }
+
+  return self->trace == NULL;
+#else
+  CHIP8_LOG_ERROR("The trace needs a build with CHIP8_TRACE_RING.\n");
+  return 1;
+#endif
+}
+
+/**
+ * @brief Writes the recorded instructions to a file, oldest first.
+ *
+ * The file starts with CHIP8_TRACE_MAGIC, the number of entries in the file
+ * and the number of instructions recorded so far, followed by the entries, all
+ * in the byte order of the host. It's decoded by tools/chip8_trace.
+ *
+ * @param self A pointer to the Chip8 object.
+ * @param path The path of the file.
+ * @return 0 on success, 1 otherwise.
+ */
+int chip8_trace_dump(const Chip8 *self, const char *path) {
+  const Chip8Trace *trace = self->trace;
+
+  if (trace == NULL) {
+    return 1;
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    CHIP8_LOG_ERROR("Can't write the trace to %s.\n", path);
+    return 1;
+  }
+
+  uint32_t size = trace->count < CHIP8_TRACE_SIZE ? (uint32_t)trace->count
+                                                  : CHIP8_TRACE_SIZE;
+  uint64_t first = trace->count - size;
+
+  fwrite(CHIP8_TRACE_MAGIC, 4, 1, file);
+  fwrite(&size, sizeof(size), 1, file);
+  fwrite(&trace->count, sizeof(trace->count), 1, file);
+
+  for (uint64_t i = first; i < trace->count; i++) {
+    fwrite(&trace->entries[i & (CHIP8_TRACE_SIZE - 1)],
+           sizeof(Chip8TraceEntry), 1, file);
+  }
+
+  fclose(file);
+
+  return 0;
+}
+
+/**
+ * @brief Stops recording, and frees the ring buffer.
+ *
+ * @param self A pointer to the Chip8 object.
+ */
+void chip8_trace_free(Chip8 *self) {
+  free(self->trace);
+  self->trace = NULL;
+}
@@ -2,10 +2,22 @@
 #define GAME_H_
 
 #include "chip8.h"
+#include "chip8_clock.h"
 
 #define OFFSET 200
 
-#define screenWidth CHIP8_SCREEN_WIDTH * 10
-#define screenHeight CHIP8_SCREEN_HEIGHT * 10
+/* The rate of the frames, and of the timers. The CPU has a rate of its own,
+ * set with --rate. */
+#define FRAMES_PER_SECOND CHIP8_CLOCK_FRAME_RATE
+
+/* The frames run for every frame presented in turbo mode, unless set with
+ * --turbo. */
+#define TURBO_FRAMES 10
+
+/* The size of a pixel of the screen, in pixels of the window. */
+#define PIXEL_SIZE 10
+
+#define screenWidth CHIP8_SCREEN_WIDTH * PIXEL_SIZE
+#define screenHeight CHIP8_SCREEN_HEIGHT * PIXEL_SIZE
 
 #endif // GAME_H_
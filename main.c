@@ -1,69 +1,570 @@
 #include "chip8.h"
+#include "chip8_aot.h"
+#include "chip8_clock.h"
+#include "chip8_frames.h"
+#include "chip8_log.h"
+#include "chip8_render.h"
+#include "chip8_stream.h"
+#include "chip8_term.h"
+#include "chip8_trace.h"
 #include "game.h"
 #include "raylib.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Runs the instructions of a frame.
+ *
+ * @return The number of instructions executed, including the ones skipped in
+ * idle loops.
+ */
+static uint32_t main_run_frame(Chip8 *chip, uint32_t budget) {
+  uint32_t executed = 0;
+  Chip8Stop stop;
+
+  /* Keep going after a draw, until the frame's budget is spent. The
+   * recompiled ROM, when one was loaded, is run by chip8_run_cycles() too. */
+  do {
+    uint64_t start = chip->cycles;
+    stop = chip8_run_cycles(chip, budget - executed);
+    executed += chip->cycles - start;
+  } while (stop == CHIP8_STOP_DRAW && executed < budget);
+
+  if (CHIP8_LOG_ENABLED(CHIP8_LOG_LEVEL_TRACE)) {
+    CHIP8_LOG_TRACE("==========Dumping registers==========\n");
+    CHIP8_LOG_TRACE("V0: 0x%02x\t, V1: 0x%02x\n", chip->registers[0],
+                    chip->registers[1]);
+    CHIP8_LOG_TRACE("V2: 0x%02x\t, V3: 0x%02x\n", chip->registers[2],
+                    chip->registers[3]);
+    CHIP8_LOG_TRACE("V4: 0x%02x\t, V5: 0x%02x\n", chip->registers[4],
+                    chip->registers[5]);
+    CHIP8_LOG_TRACE("V6: 0x%02x\t, V7: 0x%02x\n", chip->registers[6],
+                    chip->registers[7]);
+    CHIP8_LOG_TRACE("V8: 0x%02x\t, V9: 0x%02x\n", chip->registers[8],
+                    chip->registers[9]);
+    CHIP8_LOG_TRACE("VA: 0x%02x\t, VB: 0x%02x\n", chip->registers[10],
+                    chip->registers[11]);
+    CHIP8_LOG_TRACE("VC: 0x%02x\t, VD: 0x%02x\n", chip->registers[12],
+                    chip->registers[13]);
+    CHIP8_LOG_TRACE("VE: 0x%02x\t, VF: 0x%02x\n", chip->registers[14],
+                    chip->registers[15]);
+    CHIP8_LOG_TRACE("Index Registers: 0x%04x\n", chip->ir);
+    CHIP8_LOG_TRACE("Program counter: 0x%04x\n", chip->pc);
+    CHIP8_LOG_TRACE("The content of the stack 0: 0x%04x\n", chip->stack[0]);
+    CHIP8_LOG_TRACE("The content of the stack 1: 0x%04x\n", chip->stack[1]);
+    CHIP8_LOG_TRACE("The content of the stack 2: 0x%04x\n", chip->stack[2]);
+    CHIP8_LOG_TRACE("================End=================\n");
+  }
+
+  return executed;
+}
+
+/**
+ * @brief Opens a file, a named pipe or stdout, and starts streaming frames to
+ * it.
+ *
+ * @param stream A pointer to the Chip8Stream object.
+ * @param chip A pointer to the Chip8 object.
+ * @param path The file or named pipe to write to, or - for stdout.
+ * @param format The Chip8StreamFormat of the frames.
+ * @param wait Set for a recording, which waits for the writer instead of
+ * dropping frames.
+ * @return 0 on success, 1 otherwise.
+ */
+static int main_open_stream(Chip8Stream *stream, const Chip8 *chip,
+                            const char *path, Chip8StreamFormat format,
+                            uint8_t wait) {
+  int fd;
+
+  if (strcmp(path, "-") == 0) {
+    /* The core logs on stdout, so the frames go to a copy of it and the logs
+     * to stderr. */
+    fd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+  } else {
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  if (fd < 0) {
+    CHIP8_LOG_ERROR("Can't open %s for the frames.\n", path);
+    return 1;
+  }
+
+  /* A reader that leaves fails the writes, instead of killing the process. */
+  signal(SIGPIPE, SIG_IGN);
+
+  if (chip8_stream_open(stream, fd, format,
+                        chip->quirks->superchip || chip->quirks->xochip,
+                        wait) != 0) {
+    close(fd);
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Picks the format of a recording from the extension of its file.
+ *
+ * Files ending in .y4m are recorded in Y4M, and the other ones in the RLE
+ * format decoded by tools/chip8_video.
+ */
+static Chip8StreamFormat main_record_format(const char *path) {
+  const char *ext = strrchr(path, '.');
+
+  if (ext != NULL && strcasecmp(ext, ".y4m") == 0) {
+    return CHIP8_STREAM_Y4M;
+  }
+
+  return CHIP8_STREAM_RLE;
+}
+
+/* Set by Ctrl-C, to leave the headless loop and restore the terminal. */
+static volatile sig_atomic_t main_interrupted;
+
+static void main_interrupt(int signal) {
+  (void)signal;
+  main_interrupted = 1;
+}
+
+/* The emulation, run on the main thread without a window, and on a thread of
+ * its own with one. The atomics are shared with the thread of the window. */
+typedef struct main_emulation {
+  Chip8 *chip;
+  Chip8Clock clock;     /* The CPU rate, only used by the emulation. */
+  uint64_t frames;      /* The number of frames to run, or 0 until the end. */
+  Chip8Stream *stream;  /* The stream the frames are written to, or NULL. */
+  Chip8Stream *record;  /* The recording, or NULL. */
+  Chip8Term *term;      /* The terminal the frames are drawn in, or NULL. */
+  Chip8Frames *screen;  /* The frames drawn in the window, or NULL. */
+  uint32_t turbo_frames; /* The frames run for every frame presented in turbo
+                          * mode. */
+  _Atomic uint16_t keys;   /* The keys held in the window, key k in bit k. */
+  _Atomic uint32_t rate;   /* The CPU rate asked for by the window. */
+  _Atomic uint64_t ips;    /* The instructions per second last measured. */
+  _Atomic uint8_t turbo;   /* Set to run the frames as fast as possible. */
+  _Atomic uint8_t running; /* Cleared by either side to stop the emulation. */
+} MainEmulation;
+
+/**
+ * @brief Runs the ROM frame by frame, and hands the frames to the stream, the
+ * recording, the terminal and the window.
+ *
+ * The frames are paced at 60 per second with absolute deadlines, so a frame
+ * late by a few milliseconds doesn't delay the next ones. Without a window,
+ * there's no keyboard, so the keys are never pressed.
+ *
+ * In turbo mode, the frames aren't paced at all, and only one frame out of
+ * turbo_frames is presented to the stream, the terminal and the window. The
+ * frames still run the instructions and the timer ticks of 1/60 of a second,
+ * so the ROM runs the same, only faster. Every frame is still pushed to the
+ * recording, which waits for its writer rather than drop one, so turbo mode
+ * runs only as fast as the recording is written. Turbo mode ends if a frame of
+ * the recording is dropped anyway.
+ *
+ * @param arg A pointer to the MainEmulation object.
+ * @return NULL.
+ */
+static void *main_emulate(void *arg) {
+  MainEmulation *emu = arg;
+  Chip8 *chip = emu->chip;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  for (uint64_t frame = 0;
+       (emu->frames == 0 || frame < emu->frames) && !main_interrupted &&
+       atomic_load_explicit(&emu->running, memory_order_relaxed);
+       frame++) {
+    chip8_set_keys(chip,
+                   atomic_load_explicit(&emu->keys, memory_order_relaxed));
+
+    uint32_t rate = atomic_load_explicit(&emu->rate, memory_order_relaxed);
+    if (rate != emu->clock.rate) {
+      chip8_clock_set_rate(&emu->clock, rate);
+      chip8_set_rate(chip, emu->clock.rate);
+    }
+
+    uint32_t executed = main_run_frame(chip, chip8_clock_budget(&emu->clock));
+
+    /* The last frame is always presented. */
+    uint8_t turbo = atomic_load_explicit(&emu->turbo, memory_order_relaxed);
+    uint8_t present = !turbo || frame % emu->turbo_frames == 0 ||
+                      frame + 1 == emu->frames ||
+                      chip->stop == CHIP8_STOP_EXIT;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (chip8_clock_sample(&emu->clock, executed,
+                           now.tv_sec + now.tv_nsec / 1e9)) {
+      atomic_store_explicit(&emu->ips, emu->clock.ips, memory_order_relaxed);
+      if (emu->screen == NULL) {
+        CHIP8_LOG_INFO("%.0f instructions per second, for %u, x%.1f.\n",
+                       emu->clock.ips, emu->clock.rate,
+                       emu->clock.ips / emu->clock.rate);
+      }
+    }
+
+    if (emu->record != NULL && chip8_stream_push(emu->record, chip) > 0 &&
+        turbo) {
+      CHIP8_LOG_ERROR("The recording dropped a frame, leaving turbo mode.\n");
+      atomic_store_explicit(&emu->turbo, 0, memory_order_relaxed);
+    }
+
+    if (present) {
+      if (emu->stream != NULL && chip8_stream_push(emu->stream, chip) < 0) {
+        break;
+      }
+
+      /* The rows changed in the frames skipped are still dirty. */
+      uint64_t dirty = chip8_take_dirty_rows(chip);
+      if (emu->term != NULL) {
+        chip8_term_draw(emu->term, chip, dirty);
+      }
+      if (emu->screen != NULL && dirty != 0) {
+        chip8_frames_publish(emu->screen, chip, frame);
+      }
+    }
+
+    if (chip->stop == CHIP8_STOP_EXIT) {
+      break;
+    }
+
+    if (turbo) {
+      /* Pace the frames from now on once turbo mode ends. */
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      continue;
+    }
+
+    next.tv_nsec += 1000000000 / FRAMES_PER_SECOND;
+    if (next.tv_nsec >= 1000000000) {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+
+  atomic_store_explicit(&emu->running, 0, memory_order_relaxed);
+
+  return NULL;
+}
+
+/**
+ * @brief Draws the frames of the emulation in a window, until the window is
+ * closed or the emulation ends.
+ *
+ * The emulation runs on a thread of its own, so waiting for the vertical
+ * blank in EndDrawing() never slows it down, and a burst of instructions
+ * never holds up the window. The finished frames come through a triple
+ * buffer, and the keys go the other way as a mask, both without locks.
+ *
+ * @param emu A pointer to the MainEmulation object.
+ * @return 0 on success, 1 otherwise.
+ */
+static int main_run_window(MainEmulation *emu) {
+  Chip8Frames *screen = malloc(sizeof(*screen));
+  /* The screen the window draws from, copied from the frames. */
+  Chip8Screen *display = calloc(1, sizeof(*display));
+
+  if (screen == NULL || display == NULL) {
+    CHIP8_LOG_ERROR("Can't allocate the screen of the window.\n");
+    free(screen);
+    free(display);
+    return 1;
+  }
+
+  chip8_frames_init(screen);
+  /* Draw the blank screen until the first frame comes. */
+  display->dirty_rows = CHIP8_ALL_ROWS;
+  emu->screen = screen;
 
-int main(int argc, char **argv) {
-  // Initialization
   InitWindow(screenWidth, screenHeight, "Chip-8 Emulator");
 
   /* Set the game to run at 60 frames-per-second */
-  SetTargetFPS(60);
+  SetTargetFPS(FRAMES_PER_SECOND);
+
+  /* The screen, converted to RGBA pixels on the CPU and uploaded to a texture
+   * where it changed. */
+  Chip8Render render;
+  chip8_render_init(&render, PIXEL_SIZE, 1, (Chip8Rgba){0, 228, 48, 255},
+                    (Chip8Rgba){0, 0, 0, 255});
+  Image image = {.data = render.pixels,
+                 .width = render.width,
+                 .height = render.height,
+                 .mipmaps = 1,
+                 .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  Texture2D texture = LoadTextureFromImage(image);
 
-  Chip8 myChip;
+  pthread_t thread;
+  int started = pthread_create(&thread, NULL, main_emulate, emu) == 0;
+  if (!started) {
+    CHIP8_LOG_ERROR("Can't start the emulation thread.\n");
+    atomic_store_explicit(&emu->running, 0, memory_order_relaxed);
+  }
+
+  uint64_t shown_ips = 0;
 
-  /* Screen pixel parameters. */
-  Rectangle pixel = {.height = 10, .width = 10};
+  // Main game loop, until the window is closed or the emulation ends
+  while (atomic_load_explicit(&emu->running, memory_order_relaxed) &&
+         !WindowShouldClose()) {
+    atomic_store_explicit(&emu->keys, chip8_keyboard_read(),
+                          memory_order_relaxed);
 
-  chip8_init(&myChip);
-  chip8_load_rom(&myChip, argv[1]);
+    /* Page Up and Page Down double and halve the CPU rate. */
+    uint32_t rate = atomic_load_explicit(&emu->rate, memory_order_relaxed);
+    if (IsKeyPressed(KEY_PAGE_UP)) {
+      rate = chip8_clock_clamp(rate * 2);
+    }
+    if (IsKeyPressed(KEY_PAGE_DOWN)) {
+      rate = chip8_clock_clamp(rate / 2);
+    }
+    atomic_store_explicit(&emu->rate, rate, memory_order_relaxed);
 
-  // Main game loop
-  while (!WindowShouldClose()) {
+    /* Tab switches turbo mode on and off. */
+    uint8_t turbo = atomic_load_explicit(&emu->turbo, memory_order_relaxed);
+    if (IsKeyPressed(KEY_TAB)) {
+      turbo = !turbo;
+      atomic_store_explicit(&emu->turbo, turbo, memory_order_relaxed);
+    }
 
-    chip8_timer_control(&myChip);
+    const Chip8Frame *frame = chip8_frames_take(screen);
+    if (frame != NULL) {
+      chip8_frames_show(frame, display);
+    }
 
-    chip8_keyboard_control(&myChip);
+    uint64_t ips = atomic_load_explicit(&emu->ips, memory_order_relaxed);
+    if (ips != shown_ips) {
+      SetWindowTitle(TextFormat("Chip-8 Emulator - %llu/%u IPS",
+                                (unsigned long long)ips, rate));
+      shown_ips = ips;
+    }
 
     // Draw
     BeginDrawing();
     ClearBackground(GREEN);
-
-    chip8_parse_code(&myChip);
-    chip8_inst_emulate(&myChip);
-
-    printf("==========Dumping registers==========\n");
-    printf("V0: 0x%02x\t, V1: 0x%02x\n", myChip.registers[0],
-           myChip.registers[1]);
-    printf("V2: 0x%02x\t, V3: 0x%02x\n", myChip.registers[2],
-           myChip.registers[3]);
-    printf("V4: 0x%02x\t, V5: 0x%02x\n", myChip.registers[4],
-           myChip.registers[5]);
-    printf("V6: 0x%02x\t, V7: 0x%02x\n", myChip.registers[6],
-           myChip.registers[7]);
-    printf("V8: 0x%02x\t, V9: 0x%02x\n", myChip.registers[8],
-           myChip.registers[9]);
-    printf("VA: 0x%02x\t, VB: 0x%02x\n", myChip.registers[10],
-           myChip.registers[11]);
-    printf("VC: 0x%02x\t, VD: 0x%02x\n", myChip.registers[12],
-           myChip.registers[13]);
-    printf("VE: 0x%02x\t, VF: 0x%02x\n", myChip.registers[14],
-           myChip.registers[15]);
-    printf("Index Registers: 0x%04x\n", myChip.ir);
-    printf("Program counter: 0x%04x\n", myChip.pc);
-    printf("The content of the stack 0: 0x%04x\n", myChip.stack[0]);
-    printf("The content of the stack 1: 0x%04x\n", myChip.stack[1]);
-    printf("The content of the stack 2: 0x%04x\n", myChip.stack[2]);
-    printf("================End=================\n");
-
-    chip8_draw(&myChip, &pixel);
-
+    chip8_draw(display, &render, &texture);
+    if (turbo) {
+      /* The speed, drawn with the glyphs of the default font. */
+      DrawRectangle(0, 0, screenWidth, 28, Fade(BLACK, 0.6f));
+      DrawText(TextFormat("TURBO %.2f MIPS x%.1f", ips / 1e6,
+                          (double)ips / rate),
+               8, 4, 20, WHITE);
+    }
     EndDrawing();
   }
 
+  atomic_store_explicit(&emu->running, 0, memory_order_relaxed);
+  if (started) {
+    pthread_join(thread, NULL);
+  }
+
   // De-Initialization
+  UnloadTexture(texture);
+  chip8_render_deinit(&render);
   CloseWindow();
+  free(display);
+  free(screen);
+  emu->screen = NULL;
+
+  return started ? 0 : 1;
+}
+
+/**
+ * @brief Parses the decimal value of an option.
+ *
+ * @param option The option, for the error message.
+ * @param text The value to parse.
+ * @param value The parsed value.
+ * @return 0 on success, 1 if the value isn't a decimal number.
+ */
+static int main_parse_number(const char *option, const char *text,
+                             uint64_t *value) {
+  char *end;
+
+  errno = 0;
+  *value = strtoull(text, &end, 10);
+  if (text[0] < '0' || text[0] > '9' || *end != '\0' || errno != 0) {
+    CHIP8_LOG_ERROR("%s needs a number, not %s.\n", option, text);
+    return 1;
+  }
 
   return 0;
 }
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "Usage: %s ROM [--aot SO] [--trace FILE] [--stream FILE] "
+            "[--term half|braille] [--record FILE] [--format raw|pbm|y4m] "
+            "[--rate IPS] [--turbo N] [--frames N]\n",
+            argv[0]);
+    return 1;
+  }
+
+  /* Over a megabyte, with the predecoded instructions and the breakpoints. */
+  Chip8 *myChip = malloc(sizeof(*myChip));
+
+  if (myChip == NULL) {
+    CHIP8_LOG_ERROR("Can't allocate the emulator.\n");
+    return 1;
+  }
+
+  chip8_init(myChip);
+  if (chip8_load_rom(myChip, argv[1]) != 0) {
+    chip8_deinit(myChip);
+    free(myChip);
+    return 1;
+  }
+
+  const char *trace_path = NULL;
+  const char *stream_path = NULL;
+  const char *record_path = NULL;
+  const char *term_mode = NULL;
+  Chip8StreamFormat stream_format = CHIP8_STREAM_RAW;
+  uint64_t frames = 0;
+  uint32_t turbo_frames = TURBO_FRAMES;
+  uint8_t turbo = 0;
+  Chip8Clock clock;
+  int status = 0;
+
+  chip8_clock_init(&clock, CHIP8_CLOCK_DEFAULT_RATE);
+
+  /* Every option takes a value. */
+  for (int i = 2; i < argc && status == 0; i += 2) {
+    const char *option = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    uint64_t number = 0;
+
+    if (value == NULL) {
+      CHIP8_LOG_ERROR("%s needs a value.\n", option);
+      status = 1;
+    } else if (strcmp(option, "--aot") == 0) {
+      /* Run the ROM recompiled by tools/chip8_aot. */
+      status = chip8_aot_load(myChip, value);
+    } else if (strcmp(option, "--trace") == 0) {
+      /* Keep the last instructions, to be dumped on exit. */
+      status = chip8_trace_start(myChip);
+      trace_path = value;
+    } else if (strcmp(option, "--stream") == 0) {
+      /* Run without a window, and write the frames to a file or a pipe. */
+      stream_path = value;
+    } else if (strcmp(option, "--term") == 0) {
+      /* Run without a window, and draw the frames in the terminal. */
+      term_mode = value;
+      if (strcmp(value, "half") != 0 && strcmp(value, "braille") != 0) {
+        CHIP8_LOG_ERROR("--term is half or braille, not %s.\n", value);
+        status = 1;
+      }
+    } else if (strcmp(option, "--record") == 0) {
+      /* Record the frames, in Y4M or in the RLE format. */
+      record_path = value;
+    } else if (strcmp(option, "--format") == 0) {
+      if (strcmp(value, "raw") == 0) {
+        stream_format = CHIP8_STREAM_RAW;
+      } else if (strcmp(value, "pbm") == 0) {
+        stream_format = CHIP8_STREAM_PBM;
+      } else if (strcmp(value, "y4m") == 0) {
+        stream_format = CHIP8_STREAM_Y4M;
+      } else {
+        CHIP8_LOG_ERROR("--format is raw, pbm or y4m, not %s.\n", value);
+        status = 1;
+      }
+    } else if (strcmp(option, "--rate") == 0) {
+      /* The instructions per second. */
+      status = main_parse_number(option, value, &number);
+      chip8_clock_set_rate(&clock, number > UINT32_MAX ? UINT32_MAX : number);
+    } else if (strcmp(option, "--turbo") == 0) {
+      /* Run as fast as possible, and present one frame out of N. */
+      status = main_parse_number(option, value, &number);
+      turbo_frames = number > UINT32_MAX ? UINT32_MAX : number;
+      turbo = 1;
+    } else if (strcmp(option, "--frames") == 0) {
+      /* Stop after a number of frames. */
+      status = main_parse_number(option, value, &number);
+      frames = number;
+    } else {
+      CHIP8_LOG_ERROR("Unknown option %s.\n", option);
+      status = 1;
+    }
+  }
+
+  if (status != 0) {
+    chip8_deinit(myChip);
+    free(myChip);
+    return status;
+  }
+
+  /* The timers tick from the instructions run at this rate. */
+  chip8_set_rate(myChip, clock.rate);
+
+  Chip8Stream record;
+  Chip8Stream *recording = NULL;
+
+  if (record_path != NULL) {
+    status = main_open_stream(&record, myChip, record_path,
+                              main_record_format(record_path), 1);
+    recording = status == 0 ? &record : NULL;
+  }
+
+  MainEmulation emu = {.chip = myChip,
+                       .clock = clock,
+                       .frames = frames,
+                       .record = recording,
+                       .turbo_frames = turbo_frames != 0 ? turbo_frames : 1};
+  atomic_init(&emu.keys, 0);
+  atomic_init(&emu.rate, clock.rate);
+  atomic_init(&emu.ips, 0);
+  atomic_init(&emu.turbo, turbo);
+  atomic_init(&emu.running, 1);
+
+  Chip8Stream stream;
+  Chip8Term term;
+
+  if (status == 0 && (stream_path != NULL || term_mode != NULL)) {
+    if (stream_path != NULL) {
+      status = main_open_stream(&stream, myChip, stream_path, stream_format,
+                                0);
+      emu.stream = status == 0 ? &stream : NULL;
+    }
+    if (status == 0 && term_mode != NULL) {
+      status = chip8_term_init(&term, stdout,
+                               strcmp(term_mode, "braille") == 0
+                                   ? CHIP8_TERM_BRAILLE
+                                   : CHIP8_TERM_HALF);
+      emu.term = status == 0 ? &term : NULL;
+    }
+
+    if (status == 0) {
+      signal(SIGINT, main_interrupt);
+      main_emulate(&emu);
+    }
+  } else if (status == 0) {
+    status = main_run_window(&emu);
+  }
+
+  if (emu.term != NULL) {
+    chip8_term_deinit(emu.term);
+  }
+  if (emu.stream != NULL) {
+    chip8_stream_close(emu.stream);
+  }
+  if (recording != NULL) {
+    chip8_stream_close(recording);
+  }
+  if (trace_path != NULL) {
+    chip8_trace_dump(myChip, trace_path);
+  }
+  chip8_deinit(myChip);
+  free(myChip);
+
+  return status;
+}
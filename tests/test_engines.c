@@ -0,0 +1,180 @@
+/**
+ * @file test_engines.c
+ * @brief Checks that every execution engine reaches the same state.
+ *
+ * Every ROM given on the command line is run for the same number of
+ * instructions on every engine, a frame's worth of instructions at a time,
+ * starting from the same state and random seed. The final state, timers and
+ * cycles included, has to be the same as the one reached by the table engine.
+ *
+ * The aot engine runs aot/ROM.so, and is left out for the ROMs that weren't
+ * recompiled with make aot. The idle engine runs chip8_run_cycles(), which
+ * skips the idle loops, and has to reach the same state as the engines that
+ * run every iteration of them.
+ *
+ * Usage: ./tests/test_engines [-n INSTRUCTIONS] ROM...
+ */
+#include "chip8.h"
+#include "chip8_aot.h"
+#include "chip8_clock.h"
+#include "raylib.h"
+#include <libgen.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_INSTRUCTIONS 2000000
+#define RANDOM_SEED 0xC8
+
+typedef uint32_t (*engine) (Chip8 *self, uint32_t count);
+
+typedef struct {
+  const char *name;
+  engine run;
+} Engine;
+
+/**
+ * @brief Runs chip8_run_cycles() until all the instructions were executed or
+ * skipped as idle.
+ */
+static uint32_t test_run_cycles(Chip8 *self, uint32_t count) {
+  uint64_t end = self->cycles + count;
+
+  while (self->cycles < end) {
+    chip8_run_cycles(self, end - self->cycles);
+  }
+
+  return count;
+}
+
+static const Engine engines[] = {
+    {"table", chip8_execute_table},
+    {"threaded", chip8_execute_threaded},
+    {"direct", chip8_execute_direct},
+    {"jit", chip8_execute_jit},
+    {"aot", chip8_execute_aot},
+    {"idle", test_run_cycles},
+};
+
+/**
+ * @brief Computes a FNV-1a hash of the state that the ROM can observe.
+ */
+static uint32_t test_state_hash(const Chip8 *self) {
+  uint32_t hash = 2166136261u;
+  const uint8_t *parts[] = {self->registers, self->memory,
+                            (const uint8_t *)self->graphics,
+                            (const uint8_t *)self->stack};
+  size_t sizes[] = {sizeof(self->registers), sizeof(self->memory),
+                    sizeof(self->graphics), sizeof(self->stack)};
+  uint64_t values[] = {self->pc,
+                       self->ir,
+                       self->sp,
+                       self->hires,
+                       chip8_delay_timer(self),
+                       chip8_sound_timer(self),
+                       self->cycles};
+
+  for (int p = 0; p < 4; p++) {
+    for (size_t i = 0; i < sizes[p]; i++) {
+      hash = (hash ^ parts[p][i]) * 16777619u;
+    }
+  }
+
+  for (size_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+    hash = (hash ^ (uint32_t)values[v]) * 16777619u;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Loads aot/ROM.so for a ROM at roms/ROM.ch8.
+ *
+ * @return 0 on success, 1 if there's none.
+ */
+static int test_load_aot(Chip8 *self, const char *rom) {
+  char name[256];
+  char path[300];
+
+  snprintf(name, sizeof(name), "%s", rom);
+  char *base = basename(name);
+  char *ext = strrchr(base, '.');
+  if (ext != NULL) {
+    *ext = '\0';
+  }
+
+  snprintf(path, sizeof(path), "aot/%s.so", base);
+  if (access(path, R_OK) != 0) {
+    return 1;
+  }
+
+  return chip8_aot_load(self, path);
+}
+
+int main(int argc, char **argv) {
+  uint32_t instructions = DEFAULT_INSTRUCTIONS;
+  int first_rom = 1;
+  int failures = 0;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    instructions = (uint32_t)strtoul(argv[2], NULL, 0);
+    first_rom = 3;
+  }
+
+  if (first_rom >= argc) {
+    fprintf(stderr, "Usage: %s [-n INSTRUCTIONS] ROM...\n", argv[0]);
+    return 1;
+  }
+
+  /* The core is chatty on stdout, so the report goes to a copy of it. */
+  FILE *report = fdopen(dup(fileno(stdout)), "w");
+  freopen("/dev/null", "w", stdout);
+
+  static Chip8 chip;
+  uint32_t frame = CHIP8_CLOCK_DEFAULT_RATE / CHIP8_CLOCK_FRAME_RATE;
+
+  for (int r = first_rom; r < argc; r++) {
+    uint32_t expected = 0;
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+      chip8_init(&chip);
+      if (chip8_load_rom(&chip, argv[r]) != 0) {
+        fprintf(report, "FAIL %s: can't be loaded\n", argv[r]);
+        failures++;
+        break;
+      }
+      if (engines[e].run == chip8_execute_aot &&
+          test_load_aot(&chip, argv[r]) != 0) {
+        fprintf(report, "skip %-40.40s %-10s not recompiled\n", argv[r],
+                engines[e].name);
+        chip8_deinit(&chip);
+        continue;
+      }
+      SetRandomSeed(RANDOM_SEED);
+
+      for (uint32_t done = 0; done < instructions;) {
+        uint32_t left = instructions - done;
+        done += engines[e].run(&chip, left < frame ? left : frame);
+      }
+
+      uint32_t hash = test_state_hash(&chip);
+      if (e == 0) {
+        expected = hash;
+      }
+
+      fprintf(report, "%s %-40.40s %-10s %08x\n",
+              hash == expected ? "ok  " : "FAIL", argv[r], engines[e].name,
+              hash);
+      failures += hash != expected;
+
+      chip8_deinit(&chip);
+    }
+  }
+
+  fprintf(report, "%d failure(s)\n", failures);
+  fclose(report);
+
+  return failures != 0;
+}
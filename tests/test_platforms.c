@@ -0,0 +1,351 @@
+/**
+ * @file test_platforms.c
+ * @brief Checks the screen and the registers the SUPER-CHIP and XO-CHIP test
+ * ROMs leave on every engine.
+ *
+ * Every check loads its ROM, runs it for an exact number of instructions on
+ * every engine and compares what the ROM drew and computed with the values
+ * worked out by hand from its listing. The aot engine runs aot/ROM.so, and is
+ * left out for the ROMs that weren't recompiled with make aot-roms.
+ *
+ * roms/test_schip.sc8, run with the SUPER-CHIP quirks, is checked after the
+ * scrolls and at its end:
+ *
+ *   200  00FE        lowres
+ *   202  00FF        hires, clears the screen
+ *   204  A258        I = dot
+ *   206  603E        V0 = 62
+ *   208  6105        V1 = 5
+ *   20A  D011        pixel at (62, 5)
+ *   20C  00FB        scroll right, to (66, 5)
+ *   20E  00FC        scroll left, back to (62, 5)
+ *   210  00C3        scroll down, to (62, 8)
+ *   212  A25C        I = block
+ *   214  6278        V2 = 120
+ *   216  633C        V3 = 60
+ *   218  D230        16x16 at (120, 60), clipped to 8x4
+ *   21A  8CF0        VC = VF
+ *   21C  6407        V4 = 7
+ *   21E  F430        I = big digit 7
+ *   220  6500        V5 = 0
+ *   222  6600        V6 = 0
+ *   224  D56A        big 7 at (0, 0)
+ *   226  6011        V0 = 11
+ *   228  6122        V1 = 22
+ *   22A  6233        V2 = 33
+ *   22C  6344        V3 = 44
+ *   22E  F375        flags = V0 to V3
+ *   230  6000        V0 = 0
+ *   232  6100        V1 = 0
+ *   234  6200        V2 = 0
+ *   236  6300        V3 = 0
+ *   238  F385        V0 to V3 = flags
+ *   23A  6781        V7 = 81
+ *   23C  6803        V8 = 3
+ *   23E  8786        V7 >>= 1 without shift_vy
+ *   240  A25A        I = scratch
+ *   242  F155        scratch = V0 V1, I kept
+ *   244  6204        V2 = 4
+ *   246  6008        V0 = 8
+ *   248  6E00        VE = 0
+ *   24A  B24C        jump to 24C + V2
+ *   24C  6E0F        VE = F
+ *   24E  6E0F        VE = F
+ *   250  6E01        VE = 1, jumped with V2
+ *   252  1256        jump to exit
+ *   254  6E02        VE = 2, jumped with V0
+ *   256  00FD        exit
+ *   258  8000        dot
+ *   25A  0000        scratch
+ *   25C  FFFF ...    block, 32 bytes
+ *
+ * roms/test_xochip.xo8, run with the XO-CHIP quirks:
+ *
+ *   200  F000 0248   I = sprite, long
+ *   204  6F05        VF = 5
+ *   206  6001        V0 = 1
+ *   208  6102        V1 = 2
+ *   20A  8011        V0 |= V1, VF stays 5 without vf_reset
+ *   20C  8AF0        VA = VF
+ *   20E  6E00        VE = 0
+ *   210  3E00        skip the next 4 bytes, VE = 0
+ *   212  F000 6E77   skipped, 6E77 would set VE
+ *   216  F201        planes = 2
+ *   218  6400        V4 = 0
+ *   21A  650A        V5 = 10
+ *   21C  D451        row 10 of plane 1 = FF
+ *   21E  F101        planes = 1
+ *   220  00E0        clear plane 0 only
+ *   222  F301        planes = 3
+ *   224  F000 0248   I = sprite, long
+ *   228  643C        V4 = 60
+ *   22A  651E        V5 = 30
+ *   22C  D454        4 rows on planes 0 and 1 at (60, 30), wrapped
+ *   22E  8BF0        VB = VF
+ *   230  F000 1000   I = 1000
+ *   234  6D00        VD = 0
+ *   236  636D        V3 = 6D
+ *   238  6242        V2 = 42
+ *   23A  6112        V1 = 12
+ *   23C  6046        V0 = 46
+ *   23E  5302        1000 = 6D42 1246, VD = 42 and back to 246
+ *   240  5743        V7 V6 V5 V4 = 6D 42 12 46
+ *   242  60FF        V0 = FF
+ *   244  BF01        jump to F01 + V0 = 1000
+ *   246  00FD        exit
+ *   248  FF81 81FF   sprite of plane 0
+ *   24C  F0F0 0F0F   sprite of plane 1
+ *
+ * Usage: ./tests/test_platforms
+ */
+#include "chip8.h"
+#include "chip8_aot.h"
+#include "raylib.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RANDOM_SEED 0xC8
+
+typedef uint32_t (*engine) (Chip8 *self, uint32_t count);
+
+typedef struct {
+  const char *name;
+  engine run;
+} Engine;
+
+/**
+ * @brief Compares the state reached with the one expected.
+ *
+ * @return NULL if it's the one expected, what differs otherwise.
+ */
+typedef const char *(*check) (const Chip8 *self);
+
+typedef struct {
+  char *rom;
+  const char *aot; /* The recompiled ROM. */
+  uint32_t instructions;
+  check run;
+} Check;
+
+/**
+ * @brief Runs chip8_run_cycles() until all the instructions were executed or
+ * skipped as idle.
+ */
+static uint32_t test_run_cycles(Chip8 *self, uint32_t count) {
+  uint64_t end = self->cycles + count;
+
+  while (self->cycles < end) {
+    chip8_run_cycles(self, end - self->cycles);
+  }
+
+  return count;
+}
+
+static const Engine engines[] = {
+    {"table", chip8_execute_table},
+    {"threaded", chip8_execute_threaded},
+    {"direct", chip8_execute_direct},
+    {"jit", chip8_execute_jit},
+    {"aot", chip8_execute_aot},
+    {"idle", test_run_cycles},
+};
+
+static uint64_t screen[CHIP8_PLANES][CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT];
+
+/**
+ * @brief Checks the hires pixel of roms/test_schip.sc8 after 00FB, which
+ * carries it from column 62 of the first word to column 66 of the second.
+ */
+static const char *test_schip_right(const Chip8 *self) {
+  memset(screen, 0, sizeof(screen));
+  screen[0][1][5] = 1ull << (63 - 2);
+
+  if (memcmp(self->graphics, screen, sizeof(screen)) != 0) {
+    return "the pixel scrolled right by 00FB";
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Checks the hires pixel of roms/test_schip.sc8 after 00FC, which
+ * carries it back to column 62.
+ */
+static const char *test_schip_left(const Chip8 *self) {
+  memset(screen, 0, sizeof(screen));
+  screen[0][0][5] = 1ull << (63 - 62);
+
+  if (memcmp(self->graphics, screen, sizeof(screen)) != 0) {
+    return "the pixel scrolled left by 00FC";
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Checks the hires pixel of roms/test_schip.sc8 after 00C3.
+ */
+static const char *test_schip_down(const Chip8 *self) {
+  memset(screen, 0, sizeof(screen));
+  screen[0][0][8] = 1ull << (63 - 62);
+
+  if (memcmp(self->graphics, screen, sizeof(screen)) != 0) {
+    return "the pixel scrolled down by 00C3";
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Checks the end of roms/test_schip.sc8.
+ */
+static const char *test_schip(const Chip8 *self) {
+  static const uint8_t flags[4] = {0x11, 0x22, 0x33, 0x44};
+
+  memset(screen, 0, sizeof(screen));
+  screen[0][0][8] = 1ull << (63 - 62);
+  for (int r = 0; r < 10; r++) {
+    screen[0][0][r] ^=
+        (uint64_t)self->memory[BIG_FONTSET_START_ADDRESS + 7 * 10 + r] << 56;
+  }
+  for (int r = 60; r < 64; r++) {
+    screen[0][1][r] = 0xFF;
+  }
+
+  if (memcmp(self->graphics, screen, sizeof(screen)) != 0) {
+    return "the screen drawn";
+  }
+  if (!self->hires) {
+    return "the resolution";
+  }
+  if (self->registers[VC] != 0) {
+    return "the collision of the clipped sprite";
+  }
+  if (memcmp(self->flags, flags, sizeof(flags)) != 0 ||
+      self->registers[V1] != 0x22 || self->registers[V3] != 0x44) {
+    return "the registers of Fx75 and Fx85";
+  }
+  if (self->registers[V7] != 0x40) {
+    return "Vx shifted by 8xy6";
+  }
+  if (self->ir != 0x25A || self->memory[0x25A] != 0x11 ||
+      self->memory[0x25B] != 0x22) {
+    return "I moved by Fx55";
+  }
+  if (self->registers[VE] != 1 || self->pc != 0x256) {
+    return "the jump of Bxnn";
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Gives the word of a lowres row drawn from a sprite byte at column 60,
+ * which wraps its last 4 pixels to the columns 0 to 3.
+ */
+static uint64_t test_wrapped(uint8_t byte) {
+  return (uint64_t)(byte >> 4) | (uint64_t)(byte & 0xF) << 60;
+}
+
+/**
+ * @brief Checks the end of roms/test_xochip.xo8.
+ */
+static const char *test_xochip(const Chip8 *self) {
+  static const uint8_t sprite[2][4] = {{0xFF, 0x81, 0x81, 0xFF},
+                                       {0xF0, 0xF0, 0x0F, 0x0F}};
+  static const uint8_t rows[4] = {30, 31, 0, 1};
+
+  memset(screen, 0, sizeof(screen));
+  screen[1][0][10] = 0xFFull << 56;
+  for (int p = 0; p < 2; p++) {
+    for (int r = 0; r < 4; r++) {
+      screen[p][0][rows[r]] ^= test_wrapped(sprite[p][r]);
+    }
+  }
+
+  if (memcmp(self->graphics, screen, sizeof(screen)) != 0) {
+    return "the planes drawn";
+  }
+  if (self->registers[VA] != 5) {
+    return "VF reset by 8xy1";
+  }
+  if (self->registers[VE] != 0) {
+    return "the skip of F000";
+  }
+  if (self->registers[VB] != 0) {
+    return "the collision of the wrapped sprite";
+  }
+  if (self->registers[VD] != 0x42 || self->pc != 0x246) {
+    return "the code at 1000";
+  }
+  if (self->registers[V7] != 0x6D || self->registers[V6] != 0x42 ||
+      self->registers[V5] != 0x12 || self->registers[V4] != 0x46) {
+    return "the registers of 5xy2 and 5xy3";
+  }
+  if (self->ir != 0x1000 || self->planes != 3 || self->hires) {
+    return "I, the planes or the resolution";
+  }
+
+  return NULL;
+}
+
+static const Check checks[] = {
+    {"roms/test_schip.sc8", "aot/test_schip.so", 7, test_schip_right},
+    {"roms/test_schip.sc8", "aot/test_schip.so", 8, test_schip_left},
+    {"roms/test_schip.sc8", "aot/test_schip.so", 9, test_schip_down},
+    {"roms/test_schip.sc8", "aot/test_schip.so", 100, test_schip},
+    {"roms/test_xochip.xo8", "aot/test_xochip.so", 100, test_xochip},
+};
+
+int main(void) {
+  /* The core is chatty on stdout, so the report goes to a copy of it. */
+  FILE *report = fdopen(dup(fileno(stdout)), "w");
+  freopen("/dev/null", "w", stdout);
+
+  static Chip8 chip;
+  int failures = 0;
+
+  for (size_t c = 0; c < sizeof(checks) / sizeof(checks[0]); c++) {
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+      chip8_init(&chip);
+      if (chip8_load_rom(&chip, checks[c].rom) != 0) {
+        fprintf(report, "FAIL %s: can't be loaded\n", checks[c].rom);
+        failures++;
+        break;
+      }
+      if (engines[e].run == chip8_execute_aot &&
+          (access(checks[c].aot, R_OK) != 0 ||
+           chip8_aot_load(&chip, checks[c].aot) != 0)) {
+        fprintf(report, "skip %-24s %-10s not recompiled\n", checks[c].rom,
+                engines[e].name);
+        chip8_deinit(&chip);
+        continue;
+      }
+      SetRandomSeed(RANDOM_SEED);
+
+      for (uint32_t done = 0; done < checks[c].instructions;) {
+        done += engines[e].run(&chip, checks[c].instructions - done);
+      }
+
+      const char *differs = checks[c].run(&chip);
+      if (differs != NULL) {
+        fprintf(report, "FAIL %-24s %-10s after %u instructions: %s\n",
+                checks[c].rom, engines[e].name, checks[c].instructions,
+                differs);
+        failures++;
+      } else {
+        fprintf(report, "ok   %-24s %-10s after %u instructions\n",
+                checks[c].rom, engines[e].name, checks[c].instructions);
+      }
+
+      chip8_deinit(&chip);
+    }
+  }
+
+  fprintf(report, "%d failure(s)\n", failures);
+  fclose(report);
+
+  return failures != 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_stream.c
+ * @brief Checks that chip8_stream_unpackbits() gives back what
+ * chip8_stream_packbits() encoded.
+ *
+ * The buffers are blank planes, planes of sprites, runs of every length around
+ * the 128 bytes a control byte can hold, and random bytes, of every size up to
+ * the one of a 128x64 plane and a bit more. The encoded size has to stay
+ * within the bound the buffers of the streams are allocated for, and encoded
+ * bytes cut short have to be rejected.
+ *
+ * Usage: ./tests/test_stream
+ */
+#include "chip8_stream.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SIZE 2048
+
+/**
+ * @brief Fills a buffer with the pattern number kind.
+ */
+static void test_fill(uint8_t *buffer, size_t size, int kind) {
+  for (size_t i = 0; i < size; i++) {
+    switch (kind) {
+    case 0:
+      buffer[i] = 0;
+      break;
+    case 1:
+      /* A sprite every 40 bytes in a blank plane. */
+      buffer[i] = i % 40 < 5 ? 0xF0 >> (i % 4) : 0;
+      break;
+    case 2:
+      /* Runs of 1 to 200 bytes. */
+      buffer[i] = (uint8_t)(i / (1 + i % 200));
+      break;
+    case 3:
+      /* Pairs and triples, around the runs worth encoding. */
+      buffer[i] = (uint8_t)(i / (2 + i % 2));
+      break;
+    default:
+      buffer[i] = (uint8_t)rand();
+      break;
+    }
+  }
+}
+
+int main(void) {
+  static uint8_t in[MAX_SIZE];
+  static uint8_t encoded[MAX_SIZE + MAX_SIZE / 128 + 1];
+  static uint8_t out[MAX_SIZE];
+  int failures = 0;
+  int checks = 0;
+
+  srand(0xC8);
+
+  for (int kind = 0; kind < 5; kind++) {
+    for (size_t size = 0; size <= MAX_SIZE; size += size < 300 ? 1 : 37) {
+      test_fill(in, size, kind);
+
+      size_t written = chip8_stream_packbits(in, size, encoded);
+      size_t decoded =
+          chip8_stream_unpackbits(encoded, written, out, sizeof(out));
+      checks++;
+
+      if (written > size + size / 128 + 1) {
+        printf("FAIL pattern %d, %zu bytes: encoded in %zu bytes\n", kind,
+               size, written);
+        failures++;
+      } else if (decoded != size || memcmp(in, out, size) != 0) {
+        printf("FAIL pattern %d, %zu bytes: decoded %zu bytes that differ\n",
+               kind, size, decoded);
+        failures++;
+      } else if (written > 0 &&
+                 chip8_stream_unpackbits(encoded, written - 1, out,
+                                         sizeof(out)) == size) {
+        printf("FAIL pattern %d, %zu bytes: truncated bytes decoded\n", kind,
+               size);
+        failures++;
+      }
+    }
+  }
+
+  printf("%d PackBits round trips, %d failure(s)\n", checks, failures);
+
+  return failures != 0;
+}
@@ -0,0 +1,326 @@
+/**
+ * @file bench.c
+ * @brief Benchmarks the execution engines of the Chip-8 core.
+ *
+ * Every ROM given on the command line is run for the same number of
+ * instructions on every engine, starting from the same state and random seed.
+ * The time taken by each engine is reported in millions of instructions per
+ * second (MIPS), along with a hash of the final state, so that the engines can
+ * also be checked against each other.
+ *
+ * The switch engine decodes every opcode through the nested switches that the
+ * generated dispatch table replaced, to be compared with the direct engine.
+ *
+ * The aot engine runs aot/ROM.so when it was built with make aot/ROM.so, and
+ * falls back to the default engine otherwise.
+ *
+ * Usage: ./tools/bench [-n INSTRUCTIONS] ROM...
+ */
+#include "chip8.h"
+#include "chip8_aot.h"
+#include "raylib.h"
+#include <libgen.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_INSTRUCTIONS 5000000
+#define RANDOM_SEED 0xC8
+
+typedef uint32_t (*engine) (Chip8 *self, uint32_t count);
+
+typedef struct {
+  const char *name;
+  engine run;
+} Engine;
+
+/**
+ * @brief Resolves an opcode through nested switches on its nibbles, the way
+ * chip8_decode() did before the generated dispatch table, so that the direct
+ * engine can be compared with it.
+ */
+static Chip8Op bench_lookup_switch(uint16_t op_code) {
+  uint8_t x = (op_code >> 8) & 0xF;
+  uint8_t n = op_code & 0xF;
+  uint8_t kk = op_code & 0xFF;
+
+  switch (op_code >> 12) {
+  case 0x0:
+    if ((op_code & 0xFFF0) == 0x00C0) {
+      return CHIP8_OP_00CN;
+    }
+    switch (op_code) {
+    case 0x00E0:
+      return CHIP8_OP_00E0;
+    case 0x00EE:
+      return CHIP8_OP_00EE;
+    case 0x00FB:
+      return CHIP8_OP_00FB;
+    case 0x00FC:
+      return CHIP8_OP_00FC;
+    case 0x00FD:
+      return CHIP8_OP_00FD;
+    case 0x00FE:
+      return CHIP8_OP_00FE;
+    case 0x00FF:
+      return CHIP8_OP_00FF;
+    }
+    return CHIP8_OP_IGNORE;
+  case 0x1:
+    return CHIP8_OP_1NNN;
+  case 0x2:
+    return CHIP8_OP_2NNN;
+  case 0x3:
+    return CHIP8_OP_3XKK;
+  case 0x4:
+    return CHIP8_OP_4XKK;
+  case 0x5:
+    switch (n) {
+    case 0x0:
+      return CHIP8_OP_5XY0;
+    case 0x2:
+      return CHIP8_OP_5XY2;
+    case 0x3:
+      return CHIP8_OP_5XY3;
+    }
+    return CHIP8_OP_TRAP;
+  case 0x6:
+    return CHIP8_OP_6XKK;
+  case 0x7:
+    return CHIP8_OP_7XKK;
+  case 0x8:
+    switch (n) {
+    case 0x0:
+      return CHIP8_OP_8XY0;
+    case 0x1:
+      return CHIP8_OP_8XY1;
+    case 0x2:
+      return CHIP8_OP_8XY2;
+    case 0x3:
+      return CHIP8_OP_8XY3;
+    case 0x4:
+      return CHIP8_OP_8XY4;
+    case 0x5:
+      return CHIP8_OP_8XY5;
+    case 0x6:
+      return CHIP8_OP_8XY6;
+    case 0x7:
+      return CHIP8_OP_8XY7;
+    case 0xE:
+      return CHIP8_OP_8XYE;
+    }
+    return CHIP8_OP_TRAP;
+  case 0x9:
+    return n == 0 ? CHIP8_OP_9XY0 : CHIP8_OP_TRAP;
+  case 0xA:
+    return CHIP8_OP_ANNN;
+  case 0xB:
+    return CHIP8_OP_BNNN;
+  case 0xC:
+    return CHIP8_OP_CXKK;
+  case 0xD:
+    return CHIP8_OP_DXYN;
+  case 0xE:
+    switch (kk) {
+    case 0x9E:
+      return CHIP8_OP_EX9E;
+    case 0xA1:
+      return CHIP8_OP_EXA1;
+    }
+    return CHIP8_OP_TRAP;
+  }
+
+  switch (kk) {
+  case 0x00:
+    return x == 0 ? CHIP8_OP_F000 : CHIP8_OP_TRAP;
+  case 0x01:
+    return CHIP8_OP_FN01;
+  case 0x02:
+    return x == 0 ? CHIP8_OP_F002 : CHIP8_OP_TRAP;
+  case 0x07:
+    return CHIP8_OP_FX07;
+  case 0x0A:
+    return CHIP8_OP_FX0A;
+  case 0x15:
+    return CHIP8_OP_FX15;
+  case 0x18:
+    return CHIP8_OP_FX18;
+  case 0x1E:
+    return CHIP8_OP_FX1E;
+  case 0x29:
+    return CHIP8_OP_FX29;
+  case 0x30:
+    return CHIP8_OP_FX30;
+  case 0x33:
+    return CHIP8_OP_FX33;
+  case 0x3A:
+    return CHIP8_OP_FX3A;
+  case 0x55:
+    return CHIP8_OP_FX55;
+  case 0x65:
+    return CHIP8_OP_FX65;
+  case 0x75:
+    return CHIP8_OP_FX75;
+  case 0x85:
+    return CHIP8_OP_FX85;
+  }
+
+  return CHIP8_OP_TRAP;
+}
+
+/**
+ * @brief Executes instructions like chip8_execute_direct(), but resolves every
+ * opcode through bench_lookup_switch() instead of the dispatch table.
+ */
+static uint32_t bench_execute_switch(Chip8 *self, uint32_t count) {
+  Chip8Inst inst;
+
+  self->stop = CHIP8_STOP_BUDGET;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t pc = self->pc & (CHIP8_MEMORY_SIZE - 1);
+    uint16_t op_code = self->memory[pc] << 8;
+    op_code |= self->memory[(pc + 1) & (CHIP8_MEMORY_SIZE - 1)];
+    self->pc = pc + 2;
+
+    chip8_decode(op_code, &inst);
+    inst.kind = bench_lookup_switch(op_code);
+    inst.handler = self->handlers[inst.kind];
+    inst.handler(self, &inst);
+    self->cycles++;
+
+    if (self->stop != CHIP8_STOP_BUDGET) {
+      return i + 1;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief Runs chip8_run_cycles() until all the instructions were executed or
+ * skipped as idle.
+ */
+static uint32_t bench_run_cycles(Chip8 *self, uint32_t count) {
+  uint64_t end = self->cycles + count;
+
+  while (self->cycles < end) {
+    chip8_run_cycles(self, end - self->cycles);
+  }
+
+  return count;
+}
+
+static const Engine engines[] = {
+    {"table", chip8_execute_table},
+    {"threaded", chip8_execute_threaded},
+    {"direct", chip8_execute_direct},
+    {"switch", bench_execute_switch},
+    {"jit", chip8_execute_jit},
+    {"aot", chip8_execute_aot},
+    {"cycles", bench_run_cycles},
+};
+
+/**
+ * @brief Loads aot/ROM.so for a ROM at roms/ROM.ch8, if it exists.
+ */
+static void bench_load_aot(Chip8 *self, const char *rom) {
+  char name[256];
+  char path[300];
+
+  snprintf(name, sizeof(name), "%s", rom);
+  char *base = basename(name);
+  char *ext = strrchr(base, '.');
+  if (ext != NULL) {
+    *ext = '\0';
+  }
+
+  snprintf(path, sizeof(path), "aot/%s.so", base);
+  if (access(path, R_OK) == 0) {
+    chip8_aot_load(self, path);
+  }
+}
+
+/**
+ * @brief Computes a FNV-1a hash of the registers, the memory and the display.
+ */
+static uint32_t bench_state_hash(const Chip8 *self) {
+  uint32_t hash = 2166136261u;
+  const uint8_t *parts[] = {self->registers, self->memory,
+                            (const uint8_t *)self->graphics};
+  size_t sizes[] = {sizeof(self->registers), sizeof(self->memory),
+                    sizeof(self->graphics)};
+
+  for (int p = 0; p < 3; p++) {
+    for (size_t i = 0; i < sizes[p]; i++) {
+      hash = (hash ^ parts[p][i]) * 16777619u;
+    }
+  }
+
+  return hash ^ self->pc ^ ((uint32_t)self->ir << 16);
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  uint32_t instructions = DEFAULT_INSTRUCTIONS;
+  int first_rom = 1;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    instructions = (uint32_t)strtoul(argv[2], NULL, 0);
+    first_rom = 3;
+  }
+
+  if (first_rom >= argc) {
+    fprintf(stderr, "Usage: %s [-n INSTRUCTIONS] ROM...\n", argv[0]);
+    return 1;
+  }
+
+  /* The core is chatty on stdout, so the report goes to a copy of it. */
+  FILE *report = fdopen(dup(fileno(stdout)), "w");
+  freopen("/dev/null", "w", stdout);
+
+  static Chip8 chip;
+
+  fprintf(report, "%-40s %-10s %10s %10s %8s\n", "ROM", "engine", "MIPS",
+          "state", "idle");
+
+  for (int r = first_rom; r < argc; r++) {
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+      chip8_init(&chip);
+      if (chip8_load_rom(&chip, argv[r]) != 0) {
+        fprintf(stderr, "Skipping %s.\n", argv[r]);
+        break;
+      }
+      if (engines[e].run == chip8_execute_aot) {
+        bench_load_aot(&chip, argv[r]);
+      }
+      SetRandomSeed(RANDOM_SEED);
+
+      /* The engines return early when an instruction stops them. */
+      double start = bench_now();
+      for (uint32_t done = 0; done < instructions;) {
+        done += engines[e].run(&chip, instructions - done);
+      }
+      double elapsed = bench_now() - start;
+
+      fprintf(report, "%-40.40s %-10s %10.2f   %08x %7.1f%%\n", argv[r],
+              engines[e].name, instructions / elapsed / 1e6,
+              bench_state_hash(&chip),
+              100.0 * chip.idle_cycles / instructions);
+
+      chip8_deinit(&chip);
+    }
+  }
+
+  fclose(report);
+
+  return 0;
+}
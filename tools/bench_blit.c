@@ -0,0 +1,117 @@
+/**
+ * @file bench_blit.c
+ * @brief Benchmarks the sprite drawing of Dxyn.
+ *
+ * chip8_blit() draws the same sequence of random sprites, at random positions,
+ * for every sprite height from 1 to 15 and for 16x16 sprites, both clipped and
+ * wrapped, on the low and the high resolution screens. The time taken is
+ * reported in millions of sprites per second, along with a hash of the final
+ * screen, which has to stay the same when the drawing code changes.
+ *
+ * Usage: ./tools/bench_blit [-n SPRITES]
+ */
+#include "chip8.h"
+#include "chip8_blit.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SPRITES 2000000
+#define RANDOM_SEED 0xC8
+/* The number of random sprites and positions, cycled through. */
+#define SAMPLE_COUNT 1024
+
+/* A random sprite and the position it's drawn at. */
+typedef struct {
+  uint8_t sprite[CHIP8_BLIT_MAX_SPRITE];
+  uint8_t x;
+  uint8_t y;
+} Sample;
+
+static Sample samples[SAMPLE_COUNT];
+
+/**
+ * @brief Hashes the screen with FNV-1a.
+ */
+static uint64_t bench_hash(uint64_t screen[][CHIP8_HIRES_HEIGHT]) {
+  const uint8_t *bytes = (const uint8_t *)screen;
+  uint64_t hash = 0xcbf29ce484222325;
+
+  size_t size = sizeof(uint64_t[CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT]);
+
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+
+  return hash;
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Draws the samples, and prints how fast it was.
+ */
+static void bench_draw(uint8_t hires, uint8_t height, uint8_t wide,
+                       uint8_t clip, uint32_t count) {
+  uint64_t screen[CHIP8_SCREEN_WORDS][CHIP8_HIRES_HEIGHT] = {{0}};
+  uint8_t width = hires ? CHIP8_HIRES_WIDTH : CHIP8_SCREEN_WIDTH;
+  uint8_t screen_height = hires ? CHIP8_HIRES_HEIGHT : CHIP8_SCREEN_HEIGHT;
+  uint32_t erased = 0;
+
+  double start = bench_now();
+  for (uint32_t i = 0; i < count; i++) {
+    const Sample *sample = &samples[i & (SAMPLE_COUNT - 1)];
+    erased += chip8_blit(screen, width, screen_height, sample->sprite,
+                         sample->x, sample->y, height, wide, clip);
+  }
+  double elapsed = bench_now() - start;
+
+  char rows[8];
+  snprintf(rows, sizeof(rows), wide ? "16x16" : "%u", height);
+
+  printf("%-6s %-6s %-5s %10.2f   %016llx %8u\n",
+         hires ? "128x64" : "64x32", rows, clip ? "clip" : "wrap",
+         count / elapsed / 1e6, (unsigned long long)bench_hash(screen),
+         erased);
+}
+
+int main(int argc, char **argv) {
+  uint32_t count = DEFAULT_SPRITES;
+
+  if (argc == 3 && strcmp(argv[1], "-n") == 0) {
+    count = strtoul(argv[2], NULL, 10);
+  } else if (argc != 1) {
+    fprintf(stderr, "Usage: %s [-n SPRITES]\n", argv[0]);
+    return 1;
+  }
+
+  srand(RANDOM_SEED);
+  for (int i = 0; i < SAMPLE_COUNT; i++) {
+    for (int j = 0; j < CHIP8_BLIT_MAX_SPRITE; j++) {
+      samples[i].sprite[j] = rand();
+    }
+    samples[i].x = rand() % CHIP8_HIRES_WIDTH;
+    samples[i].y = rand() % CHIP8_HIRES_HEIGHT;
+  }
+
+  printf("%-6s %-6s %-5s %10s   %-16s %8s\n", "screen", "rows", "edge",
+         "Msprites/s", "screen", "erased");
+
+  for (uint8_t hires = 0; hires <= 1; hires++) {
+    for (uint8_t height = 1; height <= 16; height++) {
+      uint8_t wide = height == 16;
+
+      for (uint8_t clip = 0; clip <= 1; clip++) {
+        bench_draw(hires, height, wide, clip, count);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,366 @@
+/**
+ * @file chip8_aot.c
+ * @brief Recompiles a Chip-8 ROM ahead of time to C source.
+ *
+ * The ROM is disassembled starting from ENTRY_POINT, following every jump,
+ * call and skip to find the reachable code, which is then split into basic
+ * blocks. Every block is written out as one C function, and the table of all
+ * the blocks is exported for chip8_aot_load(). The output is meant to be built
+ * into a shared object that the emulator loads in place of the interpreter:
+ *
+ *   ./tools/chip8_aot roms/ROM.ch8 > aot/ROM.c
+ *   gcc -O2 -shared -fPIC -Ichip8/include -Iraylib/include aot/ROM.c \
+ *       -o aot/ROM.so
+ *   ./output roms/ROM.ch8 --aot aot/ROM.so
+ *
+ * The simple instructions are written inline, and the rest call
+ * chip8_execute_opcode() in the emulator, so they keep the exact behaviour of
+ * the interpreter. Bnnn jumps end their block, as their target is only known
+ * at run time. The ROMs with the .xo8 extension are recompiled for XO-CHIP,
+ * which skips F000 nnnn as a whole.
+ *
+ * Usage: ./tools/chip8_aot ROM
+ */
+#include "chip8.h"
+#include "chip8_aot.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t memory[CHIP8_MEMORY_SIZE];
+static bool reachable[CHIP8_MEMORY_SIZE];
+static bool leader[CHIP8_MEMORY_SIZE];
+
+static uint16_t worklist[CHIP8_MEMORY_SIZE];
+static uint32_t worklist_size;
+
+/* Set if the skips skip F000 nnnn as a whole, as on XO-CHIP. */
+static bool long_skip;
+
+/* The last two instructions of the memory are left to the interpreter, so that
+ * the end of every block fits in 16 bits, skipped instruction included. */
+static void aot_push(uint16_t addr) {
+  if (addr < CHIP8_MEMORY_SIZE - 4 && (addr & 1) == 0 && !reachable[addr]) {
+    reachable[addr] = true;
+    worklist[worklist_size++] = addr;
+  }
+}
+
+/* Marks the first instruction of a block, and adds it to the worklist. */
+static void aot_leader(uint16_t addr) {
+  if (addr < CHIP8_MEMORY_SIZE) {
+    leader[addr] = true;
+    aot_push(addr);
+  }
+}
+
+static void aot_decode(uint16_t addr, Chip8Inst *inst) {
+  chip8_decode(memory[addr] << 8 | memory[addr + 1], inst);
+}
+
+/**
+ * @brief Returns the size of the instruction skipped by a skip at an address.
+ */
+static uint16_t aot_skip_size(uint16_t addr) {
+  uint16_t next = addr + 2;
+
+  if (long_skip && memory[next] == 0xF0 && memory[next + 1] == 0) {
+    return 4;
+  }
+
+  return 2;
+}
+
+static bool aot_skips(uint8_t kind) {
+  switch (kind) {
+  case CHIP8_OP_3XKK:
+  case CHIP8_OP_4XKK:
+  case CHIP8_OP_5XY0:
+  case CHIP8_OP_9XY0:
+  case CHIP8_OP_EX9E:
+  case CHIP8_OP_EXA1:
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Checks if an instruction has to be the last one of a block.
+ *
+ * Besides the instructions that change the PC, the instructions that write to
+ * memory end their block, so the emulator can check if they overwrote code.
+ */
+static bool aot_ends_block(uint8_t kind) {
+  switch (kind) {
+  case CHIP8_OP_TRAP:
+  case CHIP8_OP_00EE:
+  case CHIP8_OP_00FD:
+  case CHIP8_OP_1NNN:
+  case CHIP8_OP_2NNN:
+  case CHIP8_OP_3XKK:
+  case CHIP8_OP_4XKK:
+  case CHIP8_OP_5XY0:
+  case CHIP8_OP_5XY2:
+  case CHIP8_OP_9XY0:
+  case CHIP8_OP_BNNN:
+  case CHIP8_OP_EX9E:
+  case CHIP8_OP_EXA1:
+  case CHIP8_OP_F000:
+  case CHIP8_OP_FX0A:
+  case CHIP8_OP_FX33:
+  case CHIP8_OP_FX55:
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Finds the reachable instructions, and the first instruction of every
+ * basic block.
+ */
+static void aot_discover(void) {
+  aot_leader(ENTRY_POINT);
+
+  while (worklist_size > 0) {
+    uint16_t addr = worklist[--worklist_size];
+    uint16_t next = addr + 2;
+    Chip8Inst inst;
+
+    aot_decode(addr, &inst);
+
+    switch (inst.kind) {
+    case CHIP8_OP_TRAP:
+    case CHIP8_OP_00EE:
+    case CHIP8_OP_00FD:
+    case CHIP8_OP_BNNN:
+      break;
+    case CHIP8_OP_1NNN:
+      aot_leader(inst.nnn);
+      break;
+    case CHIP8_OP_2NNN:
+      aot_leader(inst.nnn);
+      aot_leader(next);
+      break;
+    case CHIP8_OP_3XKK:
+    case CHIP8_OP_4XKK:
+    case CHIP8_OP_5XY0:
+    case CHIP8_OP_9XY0:
+    case CHIP8_OP_EX9E:
+    case CHIP8_OP_EXA1:
+      aot_leader(next);
+      aot_leader(next + aot_skip_size(addr));
+      break;
+    case CHIP8_OP_F000:
+      /* The next word is the address loaded into I. */
+      aot_leader(next + 2);
+      break;
+    default:
+      if (aot_ends_block(inst.kind)) {
+        aot_leader(next);
+      } else {
+        aot_push(next);
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Writes the C statements of a single instruction.
+ *
+ * Every instruction that ends a block leaves the PC at the next instruction to
+ * be executed. The instructions run by the interpreter see the cycles at their
+ * index in the block, as the ones that read the timers depend on them.
+ */
+static void aot_emit_inst(uint16_t addr, uint16_t index,
+                          const Chip8Inst *inst) {
+  uint16_t next = addr + 2;
+
+  printf("  /* 0x%04x: %04x */\n", addr, inst->op_code);
+
+  switch (inst->kind) {
+  case CHIP8_OP_IGNORE:
+    return;
+  case CHIP8_OP_1NNN:
+    /* The idle loops are left to the interpreter, which stops in them. */
+    if (chip8_idle_jump(memory, addr, inst->nnn)) {
+      break;
+    }
+    printf("  self->pc = 0x%04x;\n", inst->nnn);
+    return;
+  case CHIP8_OP_2NNN:
+    printf("  self->stack[self->sp & 0xf] = 0x%04x;\n", next);
+    printf("  self->sp++;\n");
+    printf("  self->pc = 0x%04x;\n", inst->nnn);
+    return;
+  case CHIP8_OP_00EE:
+    printf("  self->sp--;\n");
+    printf("  self->pc = self->stack[self->sp & 0xf];\n");
+    return;
+  case CHIP8_OP_3XKK:
+    printf("  self->pc = V[0x%x] == 0x%02x ? 0x%04x : 0x%04x;\n", inst->x,
+           inst->kk, next + aot_skip_size(addr), next);
+    return;
+  case CHIP8_OP_4XKK:
+    printf("  self->pc = V[0x%x] != 0x%02x ? 0x%04x : 0x%04x;\n", inst->x,
+           inst->kk, next + aot_skip_size(addr), next);
+    return;
+  case CHIP8_OP_5XY0:
+    printf("  self->pc = V[0x%x] == V[0x%x] ? 0x%04x : 0x%04x;\n", inst->x,
+           inst->y, next + aot_skip_size(addr), next);
+    return;
+  case CHIP8_OP_9XY0:
+    printf("  self->pc = V[0x%x] != V[0x%x] ? 0x%04x : 0x%04x;\n", inst->x,
+           inst->y, next + aot_skip_size(addr), next);
+    return;
+  case CHIP8_OP_6XKK:
+    printf("  V[0x%x] = 0x%02x;\n", inst->x, inst->kk);
+    return;
+  case CHIP8_OP_7XKK:
+    printf("  V[0x%x] += 0x%02x;\n", inst->x, inst->kk);
+    return;
+  case CHIP8_OP_8XY0:
+    printf("  V[0x%x] = V[0x%x];\n", inst->x, inst->y);
+    return;
+  case CHIP8_OP_8XY4:
+    printf("  tmp = V[0x%x] + V[0x%x];\n", inst->x, inst->y);
+    printf("  V[0x%x] = tmp;\n", inst->x);
+    printf("  V[0xf] = tmp > 255;\n");
+    return;
+  case CHIP8_OP_8XY5:
+    printf("  tmp = V[0x%x];\n", inst->x);
+    printf("  V[0x%x] -= V[0x%x];\n", inst->x, inst->y);
+    printf("  V[0xf] = tmp > V[0x%x];\n", inst->y);
+    return;
+  case CHIP8_OP_8XY7:
+    printf("  tmp = V[0x%x];\n", inst->x);
+    printf("  V[0x%x] = V[0x%x] - V[0x%x];\n", inst->x, inst->y, inst->x);
+    printf("  V[0xf] = V[0x%x] > tmp;\n", inst->y);
+    return;
+  case CHIP8_OP_ANNN:
+    printf("  self->ir = 0x%04x;\n", inst->nnn);
+    return;
+  case CHIP8_OP_FX1E:
+    printf("  self->ir += V[0x%x];\n", inst->x);
+    return;
+  }
+
+  /* Everything else runs through the interpreter's own handler. */
+  printf("  self->cycles = cycles + %u;\n", index);
+  printf("  self->pc = 0x%04x;\n", next);
+  printf("  chip8_execute_opcode(self, 0x%04x);\n", inst->op_code);
+}
+
+/**
+ * @brief Writes the C function of the basic block that starts at an address.
+ *
+ * @param start The address of the first instruction of the block.
+ * @param length Set to the number of instructions of the block.
+ * @param cover Set to the address past the instructions the block depends on,
+ * which includes the instruction skipped by a skip at its end on XO-CHIP.
+ * @return The address past the last instruction of the block.
+ */
+static uint16_t aot_emit_block(uint16_t start, uint16_t *length,
+                               uint16_t *cover) {
+  uint16_t addr = start;
+  Chip8Inst inst;
+
+  *length = 0;
+
+  printf("static uint32_t chip8_aot_block_%04x(Chip8 *self) {\n", start);
+  printf("  uint8_t *V = self->registers;\n");
+  printf("  uint64_t cycles = self->cycles;\n");
+  printf("  uint16_t tmp;\n\n");
+  printf("  (void)V;\n");
+  printf("  (void)tmp;\n\n");
+
+  do {
+    aot_decode(addr, &inst);
+    aot_emit_inst(addr, *length, &inst);
+    addr += 2;
+    (*length)++;
+
+    if (aot_ends_block(inst.kind)) {
+      break;
+    }
+  } while (*length < CHIP8_AOT_MAX_LENGTH && reachable[addr] && !leader[addr]);
+
+  *cover = long_skip && aot_skips(inst.kind) ? addr + 2 : addr;
+
+  /* The block was cut short, and simply falls through to the next one. */
+  if (!aot_ends_block(inst.kind)) {
+    printf("  self->pc = 0x%04x;\n", addr);
+  }
+  printf("  self->cycles = cycles + %u;\n", *length);
+  printf("  return %u;\n", *length);
+  printf("}\n\n");
+
+  return addr;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s ROM\n", argv[0]);
+    return 1;
+  }
+
+  FILE *rom = fopen(argv[1], "rb");
+  if (!rom) {
+    fprintf(stderr, "ROM file %s in invalid or doesn't exist!\n", argv[1]);
+    return 1;
+  }
+
+  size_t rom_size =
+      fread(&memory[ENTRY_POINT], 1, CHIP8_MEMORY_SIZE - ENTRY_POINT, rom);
+  fclose(rom);
+
+  long_skip = chip8_profile_from_name(argv[1]) == CHIP8_PROFILE_XOCHIP;
+
+  aot_discover();
+
+  printf("/* Recompiled from %s by tools/chip8_aot.c, do not edit. */\n\n",
+         argv[1]);
+  printf("#include \"chip8.h\"\n");
+  printf("#include \"chip8_aot.h\"\n");
+  printf("#include <stdint.h>\n\n");
+
+  static uint16_t starts[CHIP8_MEMORY_SIZE];
+  static uint16_t ends[CHIP8_MEMORY_SIZE];
+  static uint16_t covers[CHIP8_MEMORY_SIZE];
+  static uint16_t lengths[CHIP8_MEMORY_SIZE];
+  uint32_t block_count = 0;
+
+  for (uint32_t addr = 0; addr < CHIP8_MEMORY_SIZE; addr += 2) {
+    if (!reachable[addr]) {
+      continue;
+    }
+
+    starts[block_count] = addr;
+    ends[block_count] =
+        aot_emit_block(addr, &lengths[block_count], &covers[block_count]);
+
+    /* Carry on from the end of the block, as a new block. */
+    addr = ends[block_count] - 2;
+    block_count++;
+  }
+
+  printf("const Chip8AotBlock chip8_aot_blocks[] = {\n");
+  for (uint32_t i = 0; i < block_count; i++) {
+    printf("    {0x%04x, 0x%04x, %u, chip8_aot_block_%04x},\n", starts[i],
+           covers[i], lengths[i], starts[i]);
+  }
+  printf("};\n\n");
+
+  printf("const uint32_t chip8_aot_version = %u;\n", CHIP8_AOT_VERSION);
+  printf("const uint32_t chip8_aot_block_count = %u;\n", block_count);
+  printf("const uint32_t chip8_aot_rom_size = %zu;\n", rom_size);
+  printf("const uint32_t chip8_aot_rom_hash = 0x%08x;\n",
+         chip8_aot_hash(&memory[ENTRY_POINT], rom_size));
+
+  fprintf(stderr, "Recompiled %u blocks from %s.\n", block_count, argv[1]);
+
+  return 0;
+}
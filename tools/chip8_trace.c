@@ -0,0 +1,169 @@
+/**
+ * @file chip8_trace.c
+ * @brief Decodes the trace files written by chip8_trace_dump().
+ *
+ * Every entry is printed on its own line, oldest first, with its address, its
+ * opcode disassembled, and the values of I, Vx and Vy before it was executed:
+ *
+ *   make TRACE=1
+ *   ./output roms/ROM.ch8 --trace trace.bin
+ *   ./tools/chip8_trace trace.bin
+ *
+ * Usage: ./tools/chip8_trace TRACE
+ */
+#include "chip8.h"
+#include "chip8_trace.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* The operands printed by the format of an instruction. */
+typedef enum {
+  ARGS_NONE,
+  ARGS_N,
+  ARGS_NNN,
+  ARGS_X,
+  ARGS_XKK,
+  ARGS_XY,
+  ARGS_XYN
+} TraceArgs;
+
+typedef struct {
+  const char *format;
+  TraceArgs args;
+} TraceFormat;
+
+/* The disassembly of every instruction, indexed by Chip8Op. */
+static const TraceFormat formats[CHIP8_OP_COUNT] = {
+    [CHIP8_OP_IGNORE] = {"SYS  0x%03x", ARGS_NNN},
+    [CHIP8_OP_TRAP] = {"???", ARGS_NONE},
+    [CHIP8_OP_00CN] = {"SCD  %u", ARGS_N},
+    [CHIP8_OP_00E0] = {"CLS", ARGS_NONE},
+    [CHIP8_OP_00EE] = {"RET", ARGS_NONE},
+    [CHIP8_OP_00FB] = {"SCR", ARGS_NONE},
+    [CHIP8_OP_00FC] = {"SCL", ARGS_NONE},
+    [CHIP8_OP_00FD] = {"EXIT", ARGS_NONE},
+    [CHIP8_OP_00FE] = {"LOW", ARGS_NONE},
+    [CHIP8_OP_00FF] = {"HIGH", ARGS_NONE},
+    [CHIP8_OP_1NNN] = {"JP   0x%03x", ARGS_NNN},
+    [CHIP8_OP_2NNN] = {"CALL 0x%03x", ARGS_NNN},
+    [CHIP8_OP_3XKK] = {"SE   V%X, 0x%02x", ARGS_XKK},
+    [CHIP8_OP_4XKK] = {"SNE  V%X, 0x%02x", ARGS_XKK},
+    [CHIP8_OP_5XY0] = {"SE   V%X, V%X", ARGS_XY},
+    [CHIP8_OP_5XY2] = {"LD   [I], V%X-V%X", ARGS_XY},
+    [CHIP8_OP_5XY3] = {"LD   V%X-V%X, [I]", ARGS_XY},
+    [CHIP8_OP_6XKK] = {"LD   V%X, 0x%02x", ARGS_XKK},
+    [CHIP8_OP_7XKK] = {"ADD  V%X, 0x%02x", ARGS_XKK},
+    [CHIP8_OP_8XY0] = {"LD   V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY1] = {"OR   V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY2] = {"AND  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY3] = {"XOR  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY4] = {"ADD  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY5] = {"SUB  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY6] = {"SHR  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XY7] = {"SUBN V%X, V%X", ARGS_XY},
+    [CHIP8_OP_8XYE] = {"SHL  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_9XY0] = {"SNE  V%X, V%X", ARGS_XY},
+    [CHIP8_OP_ANNN] = {"LD   I, 0x%03x", ARGS_NNN},
+    [CHIP8_OP_BNNN] = {"JP   V0, 0x%03x", ARGS_NNN},
+    [CHIP8_OP_CXKK] = {"RND  V%X, 0x%02x", ARGS_XKK},
+    [CHIP8_OP_DXYN] = {"DRW  V%X, V%X, %u", ARGS_XYN},
+    [CHIP8_OP_EX9E] = {"SKP  V%X", ARGS_X},
+    [CHIP8_OP_EXA1] = {"SKNP V%X", ARGS_X},
+    /* The address loaded by F000 follows it, and isn't part of the trace. */
+    [CHIP8_OP_F000] = {"LD   I, LONG", ARGS_NONE},
+    [CHIP8_OP_FN01] = {"PLANE %u", ARGS_X},
+    [CHIP8_OP_F002] = {"AUDIO", ARGS_NONE},
+    [CHIP8_OP_FX07] = {"LD   V%X, DT", ARGS_X},
+    [CHIP8_OP_FX0A] = {"LD   V%X, K", ARGS_X},
+    [CHIP8_OP_FX15] = {"LD   DT, V%X", ARGS_X},
+    [CHIP8_OP_FX18] = {"LD   ST, V%X", ARGS_X},
+    [CHIP8_OP_FX1E] = {"ADD  I, V%X", ARGS_X},
+    [CHIP8_OP_FX29] = {"LD   F, V%X", ARGS_X},
+    [CHIP8_OP_FX30] = {"LD   HF, V%X", ARGS_X},
+    [CHIP8_OP_FX33] = {"LD   B, V%X", ARGS_X},
+    [CHIP8_OP_FX3A] = {"PITCH V%X", ARGS_X},
+    [CHIP8_OP_FX55] = {"LD   [I], V%X", ARGS_X},
+    [CHIP8_OP_FX65] = {"LD   V%X, [I]", ARGS_X},
+    [CHIP8_OP_FX75] = {"LD   R, V%X", ARGS_X},
+    [CHIP8_OP_FX85] = {"LD   V%X, R", ARGS_X},
+};
+
+/**
+ * @brief Writes the disassembly of an opcode into a buffer.
+ */
+static void trace_disassemble(uint16_t op_code, char *buf, size_t size) {
+  Chip8Inst inst;
+  chip8_decode(op_code, &inst);
+
+  const TraceFormat *f = &formats[inst.kind];
+
+  switch (f->args) {
+  case ARGS_NONE:
+    snprintf(buf, size, "%s", f->format);
+    break;
+  case ARGS_N:
+    snprintf(buf, size, f->format, inst.n);
+    break;
+  case ARGS_NNN:
+    snprintf(buf, size, f->format, inst.nnn);
+    break;
+  case ARGS_X:
+    snprintf(buf, size, f->format, inst.x);
+    break;
+  case ARGS_XKK:
+    snprintf(buf, size, f->format, inst.x, inst.kk);
+    break;
+  case ARGS_XY:
+    snprintf(buf, size, f->format, inst.x, inst.y);
+    break;
+  case ARGS_XYN:
+    snprintf(buf, size, f->format, inst.x, inst.y, inst.n);
+    break;
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s TRACE\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't open %s.\n", argv[1]);
+    return 1;
+  }
+
+  char magic[4];
+  uint32_t size;
+  uint64_t count;
+
+  if (fread(magic, sizeof(magic), 1, file) != 1 ||
+      memcmp(magic, CHIP8_TRACE_MAGIC, sizeof(magic)) != 0 ||
+      fread(&size, sizeof(size), 1, file) != 1 ||
+      fread(&count, sizeof(count), 1, file) != 1) {
+    fprintf(stderr, "%s isn't a trace file.\n", argv[1]);
+    fclose(file);
+    return 1;
+  }
+
+  printf("%u of %llu instructions.\n", size, (unsigned long long)count);
+  printf("%-10s %-6s %-6s %-20s %-6s %-4s %-4s\n", "#", "PC", "op", "", "I",
+         "Vx", "Vy");
+
+  Chip8TraceEntry entry;
+  char text[32];
+
+  for (uint64_t i = count - size;
+       fread(&entry, sizeof(entry), 1, file) == 1; i++) {
+    trace_disassemble(entry.op_code, text, sizeof(text));
+    printf("%-10llu 0x%03x  %04x   %-20s 0x%03x  %02x   %02x\n",
+           (unsigned long long)i, entry.pc, entry.op_code, text, entry.ir,
+           entry.vx, entry.vy);
+  }
+
+  fclose(file);
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file chip8_video.c
+ * @brief Decodes the RLE recordings written with --record into Y4M.
+ *
+ * The recording only has the frames that changed, each with its number, so
+ * every recorded frame is written again until the number of the next one:
+ *
+ *   ./output roms/ROM.ch8 --record game.c8v
+ *   ./tools/chip8_video game.c8v > game.y4m
+ *   ffmpeg -i game.y4m game.mp4
+ *
+ * Usage: ./tools/chip8_video RECORDING
+ */
+#include "chip8.h"
+#include "chip8_stream.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Converts the planes of a frame to one grey byte per pixel.
+ */
+static void video_grey(const uint8_t *planes, uint8_t mask, size_t plane_size,
+                       uint8_t *out) {
+  for (size_t i = 0; i < plane_size * 8; i++) {
+    uint8_t colour = 0;
+    const uint8_t *plane = planes;
+
+    for (int p = 0; p < CHIP8_PLANES; p++) {
+      if (mask & (1 << p)) {
+        colour |= ((plane[i / 8] >> (7 - i % 8)) & 1) << p;
+        plane += plane_size;
+      }
+    }
+
+    out[i] = chip8_stream_luma[colour];
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s RECORDING\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't open %s.\n", argv[1]);
+    return 1;
+  }
+
+  Chip8StreamRleHeader header;
+
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, CHIP8_STREAM_RLE_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s isn't a recording.\n", argv[1]);
+    fclose(file);
+    return 1;
+  }
+
+  size_t plane_size = (size_t)header.width * header.height / 8;
+  size_t encoded_size = CHIP8_PLANES * (plane_size + plane_size / 128 + 1);
+  uint8_t *encoded = malloc(encoded_size);
+  uint8_t *planes = malloc(CHIP8_PLANES * plane_size);
+  uint8_t *grey = calloc(plane_size * 8, 1);
+
+  if (encoded == NULL || planes == NULL || grey == NULL) {
+    fprintf(stderr, "Can't allocate the frames.\n");
+    return 1;
+  }
+
+  printf("YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 Cmono\n", header.width,
+         header.height, header.rate);
+
+  Chip8StreamRleFrame frame;
+  uint64_t time = 0;
+  uint64_t recorded = 0;
+  int status = 1;
+
+  while (fread(&frame, sizeof(frame), 1, file) == 1) {
+    /* Repeat the last frame until this one. */
+    for (; time < frame.time; time++) {
+      printf("FRAME\n");
+      fwrite(grey, plane_size * 8, 1, stdout);
+    }
+
+    if (frame.planes == 0) {
+      status = 0;
+      break;
+    }
+
+    size_t size = 0;
+    if (frame.size > encoded_size ||
+        fread(encoded, frame.size, 1, file) != 1 ||
+        (size = chip8_stream_unpackbits(encoded, frame.size, planes,
+                                        CHIP8_PLANES * plane_size)) !=
+            plane_size * __builtin_popcount(frame.planes)) {
+      fprintf(stderr, "Frame %llu is corrupted.\n",
+              (unsigned long long)frame.time);
+      break;
+    }
+
+    video_grey(planes, frame.planes, plane_size, grey);
+    recorded++;
+  }
+
+  if (status != 0) {
+    fprintf(stderr, "%s is truncated.\n", argv[1]);
+  }
+  fprintf(stderr, "%llu frames, %llu of them recorded.\n",
+          (unsigned long long)time, (unsigned long long)recorded);
+
+  free(encoded);
+  free(planes);
+  free(grey);
+  fclose(file);
+
+  return status;
+}
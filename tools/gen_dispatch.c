@@ -0,0 +1,106 @@
+/**
+ * @file gen_dispatch.c
+ * @brief Generates the single-level opcode dispatch table of the Chip-8 core.
+ *
+ * Every one of the 65536 possible opcodes is matched against the table of
+ * instruction patterns below, and the Chip8Op of the first matching pattern is
+ * written out as a C array. The opcodes that match no pattern are routed to
+ * CHIP8_OP_TRAP. The output is included by chip8.c, so decoding an opcode at
+ * run time is a single array lookup.
+ *
+ * Usage: ./tools/gen_dispatch > chip8/src/chip8_dispatch.inc
+ */
+#include "chip8.h"
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+  uint16_t mask;
+  uint16_t match;
+  Chip8Op op;
+} Pattern;
+
+static const Pattern patterns[] = {
+    {0xFFF0, 0x00C0, CHIP8_OP_00CN},
+    {0xFFFF, 0x00E0, CHIP8_OP_00E0},
+    {0xFFFF, 0x00EE, CHIP8_OP_00EE},
+    {0xFFFF, 0x00FB, CHIP8_OP_00FB},
+    {0xFFFF, 0x00FC, CHIP8_OP_00FC},
+    {0xFFFF, 0x00FD, CHIP8_OP_00FD},
+    {0xFFFF, 0x00FE, CHIP8_OP_00FE},
+    {0xFFFF, 0x00FF, CHIP8_OP_00FF},
+    /* 0nnn calls a machine code routine, which is ignored by interpreters. */
+    {0xF000, 0x0000, CHIP8_OP_IGNORE},
+    {0xF000, 0x1000, CHIP8_OP_1NNN},
+    {0xF000, 0x2000, CHIP8_OP_2NNN},
+    {0xF000, 0x3000, CHIP8_OP_3XKK},
+    {0xF000, 0x4000, CHIP8_OP_4XKK},
+    {0xF00F, 0x5000, CHIP8_OP_5XY0},
+    {0xF00F, 0x5002, CHIP8_OP_5XY2},
+    {0xF00F, 0x5003, CHIP8_OP_5XY3},
+    {0xF000, 0x6000, CHIP8_OP_6XKK},
+    {0xF000, 0x7000, CHIP8_OP_7XKK},
+    {0xF00F, 0x8000, CHIP8_OP_8XY0},
+    {0xF00F, 0x8001, CHIP8_OP_8XY1},
+    {0xF00F, 0x8002, CHIP8_OP_8XY2},
+    {0xF00F, 0x8003, CHIP8_OP_8XY3},
+    {0xF00F, 0x8004, CHIP8_OP_8XY4},
+    {0xF00F, 0x8005, CHIP8_OP_8XY5},
+    {0xF00F, 0x8006, CHIP8_OP_8XY6},
+    {0xF00F, 0x8007, CHIP8_OP_8XY7},
+    {0xF00F, 0x800E, CHIP8_OP_8XYE},
+    {0xF00F, 0x9000, CHIP8_OP_9XY0},
+    {0xF000, 0xA000, CHIP8_OP_ANNN},
+    {0xF000, 0xB000, CHIP8_OP_BNNN},
+    {0xF000, 0xC000, CHIP8_OP_CXKK},
+    {0xF000, 0xD000, CHIP8_OP_DXYN},
+    {0xF0FF, 0xE09E, CHIP8_OP_EX9E},
+    {0xF0FF, 0xE0A1, CHIP8_OP_EXA1},
+    /* F000 is followed by the 16-bit address it loads into I. */
+    {0xFFFF, 0xF000, CHIP8_OP_F000},
+    {0xF0FF, 0xF001, CHIP8_OP_FN01},
+    {0xFFFF, 0xF002, CHIP8_OP_F002},
+    {0xF0FF, 0xF007, CHIP8_OP_FX07},
+    {0xF0FF, 0xF00A, CHIP8_OP_FX0A},
+    {0xF0FF, 0xF015, CHIP8_OP_FX15},
+    {0xF0FF, 0xF018, CHIP8_OP_FX18},
+    {0xF0FF, 0xF01E, CHIP8_OP_FX1E},
+    {0xF0FF, 0xF029, CHIP8_OP_FX29},
+    {0xF0FF, 0xF030, CHIP8_OP_FX30},
+    {0xF0FF, 0xF033, CHIP8_OP_FX33},
+    {0xF0FF, 0xF03A, CHIP8_OP_FX3A},
+    {0xF0FF, 0xF055, CHIP8_OP_FX55},
+    {0xF0FF, 0xF065, CHIP8_OP_FX65},
+    {0xF0FF, 0xF075, CHIP8_OP_FX75},
+    {0xF0FF, 0xF085, CHIP8_OP_FX85},
+};
+
+static Chip8Op gen_lookup(uint16_t op_code) {
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    if ((op_code & patterns[i].mask) == patterns[i].match) {
+      return patterns[i].op;
+    }
+  }
+
+  return CHIP8_OP_TRAP;
+}
+
+int main(void) {
+  printf("/* Generated by tools/gen_dispatch.c, do not edit. */\n\n");
+  printf("/* The Chip8Op of every opcode, indexed by the opcode itself. */\n");
+  printf("static const uint8_t chip8_dispatch[0x10000] = {\n");
+
+  for (uint32_t op_code = 0; op_code <= 0xFFFF; op_code++) {
+    if (op_code % 16 == 0) {
+      printf("    /* 0x%04x */", op_code);
+    }
+    printf(" %2d,", gen_lookup((uint16_t)op_code));
+    if (op_code % 16 == 15) {
+      printf("\n");
+    }
+  }
+
+  printf("};\n");
+
+  return 0;
+}